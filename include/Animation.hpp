@@ -22,16 +22,33 @@ namespace Sputnik
 		float x, y;
 		float w, h;
 
-		bool is_valid()
+		bool is_valid() const
 		{
 			return w >= 0 && h >= 0;
 		}
 
-		Vector2 get_size()
+		Vector2 get_size() const
 		{
 			return { w, h };
 		}
 
+		// Edges touching counts as intersecting
+		bool intersects(const Rect& r) const
+		{
+			return x <= r.x + r.w && r.x <= x + w
+				&& y <= r.y + r.h && r.y <= y + h;
+		}
+
+		bool operator==(const Rect& r) const
+		{
+			return x == r.x && y == r.y && w == r.w && h == r.h;
+		}
+
+		bool operator!=(const Rect& r) const
+		{
+			return !(*this == r);
+		}
+
 #if SE_SDL_GPU
 		operator GPU_Rect() const { return GPU_Rect{ x, y, w, h }; }
 #endif
@@ -3,6 +3,7 @@
 
 #include "Platform.hpp"
 #include "Utils.hpp"
+#include "FramePacer.hpp"
 
 namespace Sputnik
 {
@@ -25,12 +26,60 @@ namespace Sputnik
 			return ptr;
 		}
 
+		// Jump to a scene after loading the assets it declares in Scene::preload()
+		// on background threads. The current scene keeps running meanwhile.
+		// A later jump_to() or jump_to_async() cancels the preloading.
+		void jump_to_async(const std::shared_ptr<Scene>& scene);
+
+		// Preload a scene using newly created std::shared_ptr
+		template<typename T, typename... Args>
+		std::shared_ptr<T> preload(Args&... a)
+		{
+			std::shared_ptr<T> ptr = Utils::make_shared<T>(a...);
+			jump_to_async(ptr);
+			return ptr;
+		}
+
+		bool is_preloading();
+		// Progress of the scene being preloaded from 0 to 1
+		float get_preload_progress();
+
 		const std::shared_ptr<Scene>& get_current_scene();
 		void close();
 		bool is_running();
 
+		// Averaged over the last few frames
 		float get_fps();
+		// Simulation step relative to 60 ticks per second
 		float get_fps_coef();
+
+		// Frames per second, 0 doesn't limit the rate. The default is
+		// FRAME_RATE_LIMIT from config.hpp, or the display refresh rate
+		// if the renderer doesn't wait for vsync.
+		void set_frame_rate_limit(float rate);
+		float get_frame_rate_limit();
+		// Measured duration of the last frame in seconds
+		float get_frame_time();
+		// Frame time percentiles over the last frames
+		FrameStats get_frame_stats();
+		void reset_frame_stats();
+
+		// Write the renderer counters of every frame to a CSV file,
+		// nullptr stops logging. Returns false if the file can't be opened.
+		bool log_render_counters(const char* filename);
+
+		// The simulation runs at a fixed rate independent of the frame rate,
+		// the defaults are TICK_RATE and MAX_TICKS_PER_FRAME from config.hpp
+		// Rates <= 0 are rejected
+		void set_tick_rate(float ticks_per_second);
+		float get_tick_rate();
+		// Duration of one simulation tick in seconds
+		float get_tick_delta();
+		// Limits how many ticks a slow frame catches up on
+		void set_max_ticks_per_frame(int count);
+		// How far the current frame is between the last
+		// and the next simulation tick, from 0 to 1
+		float get_render_alpha();
 	}
 }
 #endif // __APP_H__
\ No newline at end of file
@@ -2,9 +2,34 @@
 #define __AUDIO_H__
 
 #include "Resource.hpp"
+#include "Platform.hpp"
 
+#if SE_SOLOUD
 #include "soloud.h"
 #include "soloud_biquadresonantfilter.h"
+#else
+// Stand-ins for the SoLoud types used by the API below
+namespace SoLoud
+{
+	typedef unsigned int handle;
+
+	class Filter
+	{
+	public:
+		virtual ~Filter() {}
+	};
+
+	class BiquadResonantFilter : public Filter {};
+
+	class AudioSource
+	{
+	public:
+		virtual ~AudioSource() {}
+	};
+
+	class Soloud {};
+}
+#endif
 
 #include <memory>
 
@@ -18,6 +43,8 @@ namespace Sputnik
 		decent sound for games and more.
 
 		SoLoud can be found here: http://soloud-audio.com/
+
+		Without SoLoud (see SE_SOLOUD) every function is a no-op.
 	*/
 	namespace Audio
 	{
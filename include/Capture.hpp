@@ -0,0 +1,48 @@
+#ifndef __CAPTURE_H__
+#define __CAPTURE_H__
+
+#include "Renderer.hpp"
+
+namespace Sputnik
+{
+	/*
+		Saves screenshots and frame sequences without stalling the frame.
+
+		The pixels are read back into a small ring of reusable buffers,
+		encoding and writing the files happens on a worker thread.
+		The readback itself is still done by the renderer, SDL2 has
+		no asynchronous way to read the pixels.
+	*/
+	namespace Capture
+	{
+		enum class Format : char
+		{
+			PNG, // Needs SDL_image, PAM is written without it
+			PAM, // Uncompressed RGBA (netpbm)
+			Y4M, // Uncompressed YUV 4:4:4 video, sequences only
+		};
+
+		// Queue a screenshot of the current rendering target as PNG.
+		// Waits for a free buffer instead of dropping it.
+		bool screenshot(Renderer::IRenderer& renderer, const char* filename, Format format = Format::PNG);
+
+		// Capture every frame until stop_sequence(). Images are saved as
+		// path_000000.png (or .pam), a Y4M video is written to path.
+		// Frames are dropped instead of slowing down the game if the
+		// encoder can't keep up, see get_dropped_frames().
+		bool start_sequence(const char* path, Format format, float frame_rate = 60);
+		void stop_sequence();
+		bool is_capturing();
+		unsigned long get_captured_frames();
+		unsigned long get_dropped_frames();
+
+		// Called by App when the frame is rendered, before end_drawing()
+		void capture_frame(Renderer::IRenderer& renderer);
+		// Block until everything queued is written
+		void finish_all();
+		// Finish the queued images and stop the worker, called by App::quit()
+		void quit();
+	}
+}
+
+#endif // __CAPTURE_H__
@@ -0,0 +1,76 @@
+#ifndef __FRAMEPACER_H__
+#define __FRAMEPACER_H__
+
+#include <chrono>
+
+namespace Sputnik
+{
+	// Frame times in seconds over the last FramePacer::HISTORY_SIZE frames
+	struct FrameStats
+	{
+		float p50 = 0, p95 = 0, p99 = 0;
+		float max = 0;
+		// Frames measured so far, up to HISTORY_SIZE
+		int count = 0;
+	};
+
+	/*
+		Keeps frames at a target rate and measures them.
+
+		wait() sleeps until a little before the deadline of the frame
+		and spins for the rest, sleeping alone overshoots by up to
+		the scheduler granularity. The deadlines follow each other, so
+		an early frame doesn't push the next ones back.
+
+		The delta given to the game is clamped and averaged over the last
+		few frames. The average keeps the total time, a spike is spread
+		over the next frames instead of being lost.
+	*/
+	class FramePacer
+	{
+	public:
+		static constexpr int HISTORY_SIZE = 256;
+		static constexpr int SMOOTHING_FRAMES = 8;
+
+		FramePacer();
+
+		// Frames per second, 0 doesn't limit the rate
+		void set_target_rate(float rate);
+		float get_target_rate() const { return target_rate; }
+		// Longest delta returned by end_frame(), in seconds
+		void set_max_delta(float delta) { max_delta = delta; }
+
+		// Start measuring from now, before the first frame
+		void start();
+		// Block until the frame deadline
+		void wait();
+		// Start the next frame, returns the smoothed delta time
+		float end_frame();
+
+		// Measured time of the last frame, not smoothed
+		float get_raw_delta() const { return raw_delta; }
+		// Percentiles of the raw frame times
+		FrameStats get_stats() const;
+		void reset_stats();
+
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		float target_rate = 0;
+		float max_delta;
+		Clock::duration period = {};
+		Clock::time_point frame_start;
+		Clock::time_point deadline;
+
+		float raw_delta = 0;
+		float history[HISTORY_SIZE] = {};
+		int history_count = 0;
+		int history_next = 0;
+
+		float recent[SMOOTHING_FRAMES] = {};
+		int recent_count = 0;
+		int recent_next = 0;
+	};
+}
+
+#endif // __FRAMEPACER_H__
@@ -9,6 +9,7 @@
 #endif
 
 #include <functional>
+#include <cstdint>
 
 namespace Sputnik
 {
@@ -18,9 +19,13 @@ namespace Sputnik
 // Only 256 input actions are available.
 		using InputAction = uint8_t;
 
-#if SE_WINDOWS
+#if SE_SDL2
 		using PhysicalKey = SDL_Scancode;
 		constexpr int PhysicalKeyCount = SDL_NUM_SCANCODES;
+#else
+		// No keyboard without SDL, keys can still be set with set_key_held()
+		using PhysicalKey = uint16_t;
+		constexpr int PhysicalKeyCount = 512;
 #endif
 
 	// An enumeration for basic in-game actions
@@ -41,7 +46,11 @@ namespace Sputnik
 		public:
 			using Axis = uint8_t;
 			using Button = uint8_t;
+#if SE_SDL2
 			using ID = SDL_JoystickID;
+#else
+			using ID = int32_t;
+#endif
 		};
 
 		enum InputAxis : Joystick::Axis
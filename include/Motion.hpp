@@ -0,0 +1,60 @@
+#ifndef __MOTION_H__
+#define __MOTION_H__
+
+#include "Vector2.hpp"
+
+#include <vector>
+
+namespace Sputnik
+{
+	class Object;
+
+	/*
+		Structure-of-arrays storage for position, velocity and acceleration
+		of the objects with batched motion (see Object::batched_motion).
+
+		Every scene owns one. All the participating objects are integrated
+		in one vectorized pass instead of a virtual Object::update() call each.
+		The pass only touches the arrays, the results are copied to the
+		objects by sync(), which the scene calls when it visits the object
+		anyway after the update phase. Until then Object::position and
+		velocity hold the values of the previous tick.
+
+		Writes to Object::position, velocity and acceleration made since
+		the last sync() replace the integrated values, so teleports and
+		knockbacks work as usual. The set_* methods apply them right away.
+	*/
+	class MotionStore
+	{
+	public:
+		void add(Object& obj);
+		void remove(Object& obj);
+		bool contains(const Object& obj) const;
+		void clear();
+
+		size_t size() const { return owners.size(); }
+
+		// Integrate every object the same way Object::update() does
+		void integrate(float delta_time, float fps_coef);
+		// Copy the integrated motion to the object, or take the values
+		// written to the object since the last sync
+		void sync(Object& obj);
+
+		void set_position(Object& obj, Vector2 position);
+		void set_velocity(Object& obj, Vector2 velocity);
+		void set_acceleration(Object& obj, Vector2 acceleration);
+
+	private:
+		std::vector<float> pos_x, pos_y;
+		std::vector<float> vel_x, vel_y;
+		std::vector<float> acc_x, acc_y;
+		// Position and velocity as of the last sync(), to spot direct writes
+		std::vector<float> synced_pos_x, synced_pos_y;
+		std::vector<float> synced_vel_x, synced_vel_y;
+		// Integration pass each object was last synced after
+		std::vector<unsigned long> synced_pass;
+		unsigned long pass = 0;
+		std::vector<Object*> owners;
+	};
+}
+#endif // __MOTION_H__
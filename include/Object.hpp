@@ -7,6 +7,7 @@
 #include "Collision.hpp"
 #include "Font.hpp"
 #include "Color.hpp"
+#include "SlotMap.hpp"
 
 namespace Sputnik
 {
@@ -27,18 +28,114 @@ namespace Sputnik
 		// Remove the object from object list of the current scene
 		void destroy();
 		
+		// Area the object occupies in playfield coordinates.
+		// By default the size is unknown (negative), such objects
+		// are never culled and are indexed by their position.
+		virtual Rect get_bounds() const;
+		// Texture the object mostly draws with, used to group draws
+		// with the same renderer state together. nullptr if none.
+		virtual const Texture* get_render_texture() const { return nullptr; }
+		// Bounds saved by the scene once per frame after the update phase
+		const Rect& get_cached_bounds() const { return cached_bounds; }
+		void update_cached_bounds() { cached_bounds = get_bounds(); }
+
+		// Position between the last two simulation ticks for the current
+		// frame, use it in render() for smooth movement when the frame rate
+		// differs from App::get_tick_rate()
+		Vector2 get_render_position() const;
+		// Don't interpolate from the old position (e.g. after teleporting)
+		void reset_interpolation() { previous_position = position; }
+
+		// The object looks different without moving (new text, animation frame,
+		// tint...), redraws its layer if it's cached, see Scene::Layer::cached
+		void mark_changed() { changed = true; }
+
 		int get_layer() const { return layer; }
 		bool exists() const { return layer >= 0; }
 
+		/*
+			Attach the object to a parent, nullptr detaches it where it is.
+			While it has a parent, position (and the angle and scale of sprites)
+			are world values the scene sets from the local transform below in
+			flush_pending(), only for the subtrees that moved. The root of the
+			hierarchy has to be in the scene. Rotated parents with uneven scale
+			don't skew their children. Not for batched motion or parallel updates.
+			Returns false if the parent is the object itself or one of its children.
+		*/
+		bool set_parent(Object* parent);
+		Object* get_parent() const { return parent; }
+		const std::vector<Object*>& get_children() const { return children; }
+
+		// Transform relative to the parent
+		void set_local_position(Vector2 position);
+		void set_local_angle(float degrees);
+		void set_local_scale(Vector2 scale);
+		Vector2 get_local_position() const { return local_position; }
+		float get_local_angle() const { return local_angle; }
+		Vector2 get_local_scale() const { return local_scale; }
+		// Object to playfield space, as of the last flush_pending()
+		const Transform2D& get_world_transform() const { return world_transform; }
+
 		Vector2 position = { 0, 0 };
 		Vector2 velocity = { 0, 0 };
 		Vector2 acceleration = { 0, 0 };
 		bool visible = true;
+		// Objects without custom update() behavior can set this before
+		// being added to a scene: their motion is then integrated in bulk
+		// by the scene's MotionStore and update() is not called.
+		// Their position changes when the scene flushes, not during updates.
+		bool batched_motion = false;
+		// Draw order inside layers that sort their render queue,
+		// lower values are drawn first
+		int z = 0;
+		// Set if update() only touches this object, so the scene can
+		// update it on a worker thread together with other such objects.
+		// Scene changes it makes (destroy(), create_object() etc.) are queued.
+		bool parallel_update = false;
+
+	protected:
+		// Rotation and scale the children inherit, the scene sets
+		// the world values on objects that have a parent
+		virtual void get_rotation_scale(float& degrees, Vector2& scale) const { degrees = 0; scale = { 1, 1 }; }
+		virtual void set_rotation_scale(float /*degrees*/, Vector2 /*scale*/) {}
 
 	private:
 		int layer = -1;
+		// Handle in the object store of the layer
+		Utils::SlotHandle handle;
+		// Layer the object is queued to be added to, see Scene::flush_pending()
+		int pending_layer = -1;
+		bool pending_removal = false;
+		// Index in the motion store of the scene, -1 if not batched
+		int motion_index = -1;
+		Rect cached_bounds = { 0, 0, -1, -1 };
+		// Set by mark_changed(), bounds and visibility changes, cleared when drawn
+		bool changed = true;
+		bool cached_visible = true;
+		// Position before the last simulation tick
+		Vector2 previous_position = { 0, 0 };
+
+		// Hierarchy, see set_parent()
+		Object* parent = nullptr;
+		std::vector<Object*> children;
+		Vector2 local_position = { 0, 0 };
+		float local_angle = 0;
+		Vector2 local_scale = { 1, 1 };
+		float world_angle = 0;
+		Vector2 world_scale = { 1, 1 };
+		Transform2D world_transform;
+		// The local transform changed since the last pass
+		bool transform_dirty = true;
+		// An object under this one has transform_dirty set
+		bool children_dirty = false;
+
+		void mark_transform_dirty();
+		// Returns true if the root moved since the last pass
+		bool update_root_transform();
+		void update_child_transform();
 
 		friend class Scene;
+		friend class MotionStore;
 	};
 
 	/*
@@ -52,6 +149,9 @@ namespace Sputnik
 			: flip_x(false), flip_y(false) {}
 		void update(float delta_time) override;
 		void render(float delta_time) override;
+		// Takes sprite_rect (or the whole sprite), scale and angle into account
+		Rect get_bounds() const override;
+		const Texture* get_render_texture() const override { return &sprite; }
 
 		const Texture& get_sprite() const { return sprite; }
 		
@@ -63,11 +163,32 @@ namespace Sputnik
 	protected:
 		Texture sprite;
 		Rect sprite_rect = { 0, 0, -1, -1 };
+
+		void get_rotation_scale(float& degrees, Vector2& scale) const override
+		{
+			degrees = angle;
+			scale = this->scale;
+		}
+		void set_rotation_scale(float degrees, Vector2 scale) override
+		{
+			angle = degrees;
+			this->scale = scale;
+		}
+
+	private:
+		// sin/cos are only recomputed when the angle changes
+		mutable float bounds_angle = 0;
+		mutable float bounds_sin = 0, bounds_cos = 1;
 	};
 
 	/*
 		TileMapObject is a subclass of Object that represents a tile map in the game world.
 		It contains a tileset, layout and collisions for tiles.
+
+		If the renderer supports render targets, the map is drawn into cached chunks
+		of CHUNK_TILES x CHUNK_TILES tiles, so a visible chunk costs one draw.
+		Chunks are only redrawn when they are visible and their tiles changed.
+		Translucent tiles are blended twice that way, turn use_chunks off for such tilesets.
 	*/
 	class TileMapObject : public Object, public Collision::ICollidable
 	{
@@ -75,6 +196,8 @@ namespace Sputnik
 		// 65k tiles should be enough
 		using Tile = uint16_t;
 
+		static constexpr int CHUNK_TILES = 8;
+
 		struct LayoutHeader
 		{
 			uint16_t horizontal_tiles;
@@ -85,6 +208,8 @@ namespace Sputnik
 			: tile_width(tile_width), tile_height(tile_height) {}
 		void render(float delta_time) override;
 		virtual void render_tile(Tile tile, int x, int y);
+		Rect get_bounds() const override;
+		const Texture* get_render_texture() const override { return &image; }
 
 		void load_image(const char* filename);
 		void load_image(unsigned char* buffer, int size);
@@ -98,8 +223,18 @@ namespace Sputnik
 		Collision::Group& get_tile_collision(Tile tile);
 		uint16_t get_tile_count() const;
 
+		// 0 outside the map
+		Tile get_tile(int x, int y);
+		// Writes to the layout data, only the chunk containing the tile is redrawn
+		void set_tile(int x, int y, Tile tile);
+		// Redraw all the chunks, e.g. after changing the tint of the image
+		void invalidate();
+
 		bool check_collision(Vector2 p) override;
 
+		// Draw every tile each frame instead of using the chunks
+		bool use_chunks = true;
+
 	protected:
 		int tile_width;
 		int tile_height;
@@ -114,10 +249,27 @@ namespace Sputnik
 		uint16_t horizontal_tiles = 0;
 		uint16_t vertical_tiles = 0;
 		std::vector<Collision::Group> tile_collisions;
+		// Subtracted from the tile positions in render_tile(),
+		// it's the chunk position while the chunk is being drawn
+		Vector2 render_origin = { 0, 0 };
 
-		Tile get_tile(int x, int y);
 		Rect get_tile_rect(Tile id);
 		void setup();
+
+	private:
+		struct Chunk
+		{
+			Texture texture;
+			bool dirty = true;
+		};
+
+		std::vector<Chunk> chunks;
+		int chunks_h = 0;
+
+		void render_tiles(int left, int top, int right, int bottom);
+		// Returns false if the renderer can't draw into the chunk
+		bool render_chunks(int left, int top, int right, int bottom);
+		bool redraw_chunk(Chunk& chunk, int cx, int cy);
 	};
 
 	// Helper functions
@@ -166,6 +318,7 @@ namespace Sputnik
 		{
 			sprite = _private::_render_text<CHAR>(*font, str, color);
 			last_text = str;
+			mark_changed();
 		}
 
 		const CHAR* get_text() const
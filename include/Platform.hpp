@@ -18,6 +18,21 @@
 #define SE_SDL2 (SE_WINDOWS)
 // SDL gpu is optional
 #define SE_SDL_GPU ((SE_WINDOWS /* || more platforms here */ ) && SE_SDL2 && !NO_SDL_GPU)
+// Without SoLoud the audio API is kept but plays nothing
+#define SE_SOLOUD (SE_WINDOWS)
+// libpng decodes the images where SDL_image is missing,
+// the build defines SE_LIBPNG when it finds the library
+#ifndef SE_LIBPNG
+#define SE_LIBPNG 0
+#endif
+
+// SIMD instruction sets available at compile time
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SE_SSE2 1
+#else
+#define SE_SSE2 0
+#endif
 
 // Function name
 
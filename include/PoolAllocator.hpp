@@ -0,0 +1,127 @@
+#ifndef __POOLALLOCATOR_H__
+#define __POOLALLOCATOR_H__
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <new>
+
+namespace Sputnik
+{
+	namespace Utils
+	{
+		struct PoolStats
+		{
+			size_t slot_size = 0;
+			// Slots allocated from the system
+			size_t capacity = 0;
+			// Slots in use right now
+			size_t used = 0;
+			// The most slots that were in use at once
+			size_t high_water = 0;
+		};
+
+		/*
+			Fixed-size slot allocator. Slots are carved out of slabs
+			that are never returned to the system, and freed slots
+			are recycled through an intrusive free list.
+		*/
+		class SlabPool
+		{
+		public:
+			SlabPool() = default;
+			SlabPool(const SlabPool&) = delete;
+			SlabPool& operator = (const SlabPool&) = delete;
+
+			// Returns nullptr if the pool is already set up for another size
+			void* allocate(size_t size);
+			void deallocate(void* ptr);
+			// True if allocate() serves blocks of this size
+			bool serves(size_t size);
+
+			PoolStats get_stats();
+
+		private:
+			struct FreeSlot
+			{
+				FreeSlot* next;
+			};
+
+			std::mutex mutex;
+			size_t requested_size = 0;
+			size_t slot_size = 0;
+			FreeSlot* free_list = nullptr;
+			std::vector<std::unique_ptr<unsigned char[]>> slabs;
+			PoolStats stats;
+
+			void grow();
+		};
+
+		// One pool per tag type
+		template<typename Tag>
+		SlabPool& get_tagged_pool()
+		{
+			// Never destroyed, objects can outlive static destructors
+			static SlabPool* pool = new SlabPool();
+			return *pool;
+		}
+
+		/*
+			Allocator for std::allocate_shared that serves single
+			allocations from the pool of the Tag type.
+			std::allocate_shared rebinds it to its internal control block type,
+			so the object and its control block share one pooled slot.
+		*/
+		template<typename T, typename Tag = T>
+		class PoolAllocator
+		{
+		public:
+			using value_type = T;
+
+			template<typename U>
+			struct rebind
+			{
+				using other = PoolAllocator<U, Tag>;
+			};
+
+			PoolAllocator() = default;
+
+			template<typename U>
+			PoolAllocator(const PoolAllocator<U, Tag>&) {}
+
+			T* allocate(size_t n)
+			{
+				if (n == 1)
+				{
+					void* ptr = get_tagged_pool<Tag>().allocate(sizeof(T));
+					if (ptr)
+						return static_cast<T*>(ptr);
+				}
+				return static_cast<T*>(::operator new(n * sizeof(T)));
+			}
+
+			void deallocate(T* ptr, size_t n)
+			{
+				if (n == 1 && get_tagged_pool<Tag>().serves(sizeof(T)))
+					get_tagged_pool<Tag>().deallocate(ptr);
+				else
+					::operator delete(ptr);
+			}
+
+			template<typename U>
+			bool operator == (const PoolAllocator<U, Tag>&) const { return true; }
+
+			template<typename U>
+			bool operator != (const PoolAllocator<U, Tag>&) const { return false; }
+		};
+
+		// Pool usage of the objects created with PoolAllocator<T>
+		template<typename T>
+		PoolStats get_pool_stats()
+		{
+			return get_tagged_pool<T>().get_stats();
+		}
+	}
+}
+#endif // __POOLALLOCATOR_H__
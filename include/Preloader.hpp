@@ -0,0 +1,85 @@
+#ifndef __PRELOADER_H__
+#define __PRELOADER_H__
+
+#include "Renderer.hpp"
+#include "Resource.hpp"
+#include "Audio.hpp"
+#include "Font.hpp"
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace Sputnik
+{
+	/*
+		Loads the assets a scene declares in Scene::preload().
+
+		Every asset is loaded in two steps: the expensive part (reading
+		and decoding) runs on the workers of Utils::ThreadPool, the part
+		that needs the renderer or other main-thread-only state runs in
+		poll(). Textures are decoded by DecodedImage and shared through
+		TextureCache.
+		App polls the preloader once per frame while the current scene
+		keeps running and switches scenes once is_ready() is true.
+	*/
+	class AssetPreloader
+	{
+	public:
+		AssetPreloader() = default;
+		// Waits for the assets being loaded, the ones not loaded yet stay empty
+		~AssetPreloader();
+
+		AssetPreloader(const AssetPreloader&) = delete;
+		AssetPreloader& operator = (const AssetPreloader&) = delete;
+
+		// The targets must stay alive until the preloader is done,
+		// usually they are members of the scene being preloaded
+		void texture(Texture& target, const char* filename);
+		void texture(Texture& target, Resource::Handle resource);
+		void sound(Audio::Sound::SFX& target, Resource::Handle resource);
+#if SE_TTF_AVAILABLE
+		// Fonts are opened in poll(), SDL_ttf is not thread-safe
+		void font(std::shared_ptr<IFont>& target, Resource::Handle resource, int ptsize);
+#endif
+		// load runs on a background thread, finish on the main thread.
+		// Either of them can be empty.
+		void custom(std::function<void()> load, std::function<void()> finish = nullptr);
+
+		// Start loading the declared assets
+		void start();
+		// Finish the assets decoded so far, call it from the main thread.
+		// Returns true if everything is loaded.
+		bool poll();
+
+		bool is_ready() const { return finished == jobs.size(); }
+		// From 0 to 1
+		float get_progress() const;
+
+	private:
+		struct Job
+		{
+			std::function<void()> load;
+			std::function<void()> finish;
+		};
+
+		std::vector<Job> jobs;
+		bool started = false;
+		std::atomic<bool> cancelled{ false };
+		size_t finished = 0;
+
+		// Jobs loaded by the pool and waiting for poll()
+		std::mutex loaded_mutex;
+		std::condition_variable loaded_condition;
+		std::deque<size_t> loaded;
+		// Jobs queued on the pool and not loaded yet
+		size_t loading = 0;
+
+		void load_job(size_t index);
+	};
+}
+#endif // __PRELOADER_H__
@@ -9,6 +9,8 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <functional>
 
 namespace Sputnik
 {
@@ -28,6 +30,8 @@ namespace Sputnik
 			CAMERA_ROTATION, // Camera rotation support
 			SHADERS, // Custom shaders support
 			SCREENSHOT, // Screenshots support
+			RENDER_THREAD, // Can be used from a thread other than the one that created it
+			VSYNC, // end_drawing() waits for the display refresh
 
 			// Surface should be supported if render targets are supported
 			SURFACE = RENDER_TARGET,
@@ -47,14 +51,56 @@ namespace Sputnik
 			MULTIPLY,
 		};
 
+		// Defined in renderers/Recording.hpp
+		class Recording_Renderer;
+
 		// Base class for renderer-specific texture data
 		class TextureData
 		{
 		public:
 			TextureData();
 			virtual ~TextureData();
+
+			// Set by the renderer that creates the data, it's counted
+			// in FrameCounters until freed. 4 bytes per pixel.
+			void set_memory_usage(Vector2Int size, bool render_target);
+
+		private:
+			size_t memory = 0;
+			bool render_target = false;
+		};
+
+		// Pixels read back from a renderer, RGBA rows without padding
+		struct PixelBuffer
+		{
+			std::vector<Color> pixels;
+			Vector2Int size = {};
 		};
 
+		// Work done by the renderer in one frame, reset by start_drawing()
+		struct FrameCounters
+		{
+			// Calls to the graphics API that draw, batches count once
+			unsigned draw_calls = 0;
+			unsigned textured_quads = 0;
+			// pixel(), line(), rectangle and circle calls
+			unsigned primitives = 0;
+			// Changes of the texture being drawn
+			unsigned texture_binds = 0;
+			unsigned blend_switches = 0;
+			unsigned target_switches = 0;
+			// Estimated from the drawn areas (exact for the software renderer)
+			unsigned long long pixels_filled = 0;
+
+			// Not reset, the state at the time of get_counters()
+			size_t texture_memory = 0; // bytes
+			unsigned render_targets = 0;
+		};
+
+		// Column names for to_csv(), without a line break
+		const char* get_counters_csv_header();
+		std::string to_csv(const FrameCounters& counters);
+
 		/*
 			IRenderer interface
 
@@ -76,6 +122,7 @@ namespace Sputnik
 			virtual std::string get_name() = 0;
 
 			virtual void enable_camera(bool flag) = 0;
+			virtual bool is_camera_enabled() = 0;
 			virtual void apply_camera(const Camera& camera) = 0;
 
 			virtual void set_default_scale_mode(ScaleMode mode) = 0;
@@ -137,11 +184,23 @@ namespace Sputnik
 			virtual void draw_texture_transform(const Texture& texture, Vector2 pos,
 				Rect texture_rect, Vector2 scale, float degrees) = 0;
 
-			// Save the current rendering target image to a file.
-			// Returns true if successful.
-			virtual bool take_screenshot(const char* filename) = 0;
+			// Save the current rendering target image to a PNG file.
+			// The image is read now and saved on a worker thread by Capture,
+			// returns true if it's queued.
+			bool take_screenshot(const char* filename);
+
+			// Copy the current rendering target image to the buffer, reusing
+			// its memory, and call done with the result. done may be called
+			// later from another thread, the buffer must stay alive until then.
+			virtual void read_pixels(PixelBuffer& buffer, std::function<void(bool)> done) = 0;
+
+			// Counters of the frame being drawn, between frames the ones of the last frame
+			virtual FrameCounters get_counters();
 
 		protected:
+			// Filled by the backends, reset in start_drawing()
+			FrameCounters counters;
+
 			/* Next methods are only available to use publicly through Texture class */
 			
 			virtual std::unique_ptr<TextureData> create_texture(int w, int h, bool texture_target) = 0;
@@ -168,6 +227,8 @@ namespace Sputnik
 			virtual Color get_texture_tint(const Texture& texture) = 0;
 
 			friend Texture;
+			// Forwards these calls to the renderer it records for
+			friend Recording_Renderer;
 		};
 	}
 
@@ -220,12 +281,23 @@ namespace Sputnik
 		// NOTE: the buffer is not freed by this method
 		void load_from_buffer(unsigned char* buffer, int size);
 		void load_from_resource(Resource::Handle resource);
+		// Share the texture with the others loaded from the same file or resource,
+		// the image is only decoded once. The tint, blend and scale mode are shared too.
+		void load_shared_from_file(const char* filename);
+		void load_shared_from_resource(Resource::Handle resource);
 #if SE_SDL2
 		// NOTE: surface is not freed by this method
 		void load_from_SDL_surface(SDL_Surface* surface);
+		// Shared under the TextureCache key, the surface is only used if nothing is cached
+		void load_shared_from_SDL_surface(SDL_Surface* surface, const std::string& key);
 #endif
 		
 		void free();
+		bool is_loaded() const { return data != nullptr; }
+		// Number of textures sharing the data, see load_shared_from_file()
+		long get_use_count() const { return data.use_count(); }
+		// Identifies the renderer-side texture, e.g. for batching draws
+		const void* get_id() const { return data.get(); }
 
 		int get_width() const;
 		int get_height() const;
@@ -247,9 +319,37 @@ namespace Sputnik
 		const T& get_const_data() const { return static_cast<const T&>(*data); }
 
 	private:
-		std::unique_ptr<Renderer::TextureData> data;
+		std::shared_ptr<Renderer::TextureData> data;
+
+		// Keeps the textures of the renderer it records for
+		friend Renderer::Recording_Renderer;
 	};
 
+	/*
+		Cache of the textures loaded with Texture::load_shared_*().
+		Entries are keyed by the file name or by the resource and its data,
+		they are freed with the last texture that uses them.
+	*/
+	namespace TextureCache
+	{
+		struct Stats
+		{
+			unsigned long hits = 0;
+			unsigned long misses = 0;
+			// Entries still used by textures
+			size_t entries = 0;
+		};
+
+		Stats get_stats();
+		void reset_stats();
+
+		// Keys of the textures loaded from a file or a resource
+		std::string get_key(const char* filename);
+		std::string get_key(Resource::Handle resource);
+		// A texture with the key is still used
+		bool contains(const std::string& key);
+	}
+
 	/* Defined in App.cpp */
 	IWindow& get_window();
 	Renderer::IRenderer& get_current_renderer();
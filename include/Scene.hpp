@@ -4,15 +4,21 @@
 #include "Vector2.hpp"
 #include "Animation.hpp"
 #include "Utils.hpp"
+#include "Renderer.hpp"
+#include "SlotMap.hpp"
+#include "Motion.hpp"
+#include "PoolAllocator.hpp"
+#include "SpatialIndex.hpp"
 
 #include <vector>
-#include <list>
 #include <memory>
+#include <mutex>
 
 namespace Sputnik
 {
 	class Object;
 	class Texture;
+	class AssetPreloader;
 
 	// TODO: turn fade into an object
 	class Scene
@@ -21,13 +27,53 @@ namespace Sputnik
 		class Layer
 		{
 		public:
+			using ObjectStore = Utils::SlotMap<std::shared_ptr<Object>>;
+
+			enum class RenderOrder : char
+			{
+				// Strict painter's order: objects are drawn as they were added
+				INSERTION,
+				// Objects are stably sorted by (Object::z, blend mode, texture)
+				// to reduce renderer state switches
+				STATE_SORTED,
+			};
+
 			bool follow_camera;
-			const std::list<std::shared_ptr<Object>>& get_objects() const { return objects; }
+			RenderOrder render_order = RenderOrder::INSERTION;
+			/*
+				Draw the layer into a surface-sized render target and only redraw it
+				when an object was added, removed, moved, changed its bounds or
+				visibility, or called Object::mark_changed(). Other frames cost one draw.
+				Meant for HUDs and static decorations, a layer that follows a moving
+				camera is redrawn every frame. Translucent pixels are blended twice
+				(into the cache and onto the screen), so they come out darker or more
+				opaque; keep antialiased text and other translucent sprites off it.
+				Objects that draw into render targets themselves (e.g. TileMapObject
+				chunks) can't be on a cached layer.
+			*/
+			bool cached = false;
+			const ObjectStore& get_objects() const { return objects; }
 			
 			Layer(bool follow_camera = true) : follow_camera(follow_camera) {}
 
+			// Keep the objects of this layer in a spatial hash for region queries.
+			// The index is refreshed once per frame in Scene::flush_pending().
+			void enable_spatial_index(float cell_size = 64.f);
+			// nullptr if not enabled
+			SpatialIndex* get_spatial_index() { return spatial_index.get(); }
+
+			// Redraw the cache on the next frame
+			void invalidate_cache() { cache_dirty = true; }
+
 		private:
-			std::list<std::shared_ptr<Object>> objects;
+			ObjectStore objects;
+			std::unique_ptr<SpatialIndex> spatial_index;
+
+			Texture cache;
+			bool cache_dirty = true;
+			// View and camera angle the cache was drawn with
+			Rect cache_view = { 0, 0, -1, -1 };
+			float cache_angle = 0;
 
 			friend Scene;
 		};
@@ -37,6 +83,11 @@ namespace Sputnik
 		Scene();
 		virtual ~Scene();
 
+		// Declare the assets to load in the background before the scene
+		// is switched to by App::jump_to_async(). Called on the main thread
+		// while the previous scene is still the current one.
+		virtual void preload(AssetPreloader& assets);
+
 		// The scene is initialized for the first time here.
 		// App::get_current_scene() is this scene.
 		// WARNING: the line above is NOT the case for the scene's constructor!
@@ -52,9 +103,20 @@ namespace Sputnik
 		// App::get_current_scene() is this scene.
 		virtual void quit();
 
+		// Updates the objects layer by layer. In every layer the objects
+		// with Object::parallel_update set are updated on the thread pool
+		// first, then the rest are updated in order on this thread.
 		virtual void update(float delta_time);
+		// Renders the visible objects layer by layer, objects whose cached bounds
+		// are outside the camera view are skipped without calling render().
 		virtual void render(float delta_time);
 
+		/*
+			While the scene is deferring changes (App does that for the whole
+			update phase of a frame), adding, moving and removing objects
+			is queued and applied in one batch by flush_pending().
+			Otherwise the changes are applied right away.
+		*/
 		void add_object(const std::shared_ptr<Object>& obj, int layer);
 		// Does NOT free the object when out of scope, useful for
 		// objects that are properties of a scene's class
@@ -63,10 +125,18 @@ namespace Sputnik
 		void remove_object(const std::shared_ptr<Object>& obj, int layer);
 		void remove_object(Object& obj, int layer);
 
+		void set_deferred(bool flag) { deferred = flag; }
+		bool is_deferred() const { return deferred; }
+		// Apply the queued changes and compact every layer once.
+		// Called by App once per frame after the update phase.
+		void flush_pending();
+
+		// The object and its control block are allocated from a pool
+		// shared by all objects of type T, see Utils::get_pool_stats<T>()
 		template<typename T, typename... Args>
 		std::shared_ptr<T> create_object(int layer, const Args&... args)
 		{
-			std::shared_ptr<T> obj = Utils::make_shared<T>(args...);
+			std::shared_ptr<T> obj = std::allocate_shared<T>(Utils::PoolAllocator<T>(), args...);
 			add_object(obj, layer);
 			return obj;
 		}
@@ -76,9 +146,40 @@ namespace Sputnik
 		std::shared_ptr<Object> find_object(T func)
 		{
 			for (Layer& l : layers)
-				for (std::shared_ptr<Object>& obj : l.objects)
-					if (func(obj))
-						return obj;
+				for (size_t i = 0; i < l.objects.dense_size(); i++)
+					if (l.objects.is_alive_at(i) && func(l.objects.at_dense(i)))
+						return l.objects.at_dense(i);
+			return {};
+		}
+
+		// Same as above, but only objects whose bounds intersect the region are checked.
+		// Layers with a spatial index are queried through it.
+		template<typename T>
+		std::shared_ptr<Object> find_object(Rect region, T func)
+		{
+			for (Layer& l : layers)
+			{
+				if (l.spatial_index)
+				{
+					std::shared_ptr<Object> found;
+					l.spatial_index->query_rect(region, [&](Object& obj) {
+						if (found)
+							return;
+						std::shared_ptr<Object>* stored = get_stored(l, obj);
+						if (stored && func(*stored))
+							found = *stored;
+						});
+					if (found)
+						return found;
+				}
+				else
+				{
+					for (size_t i = 0; i < l.objects.dense_size(); i++)
+						if (l.objects.is_alive_at(i) && in_region(*l.objects.at_dense(i), region)
+							&& func(l.objects.at_dense(i)))
+							return l.objects.at_dense(i);
+				}
+			}
 			return {};
 		}
 
@@ -86,12 +187,64 @@ namespace Sputnik
 		void add_layer(int id = -1, Layer params = Layer());
 		Layer& get_layer(int layer);
 
+		// Motion of the objects with Object::batched_motion set
+		MotionStore& get_motion_store() { return motion; }
+
 		void set_initialized() { initialized = true; }
 		bool is_initialized() const { return initialized; }
 
 	private:
+		struct PendingChange
+		{
+			enum class Type : char
+			{
+				ADD,
+				REMOVE,
+			};
+
+			Type type;
+			Object* object;
+			// Keeps the object alive until the change is applied
+			std::shared_ptr<Object> ref;
+			int layer;
+		};
+
 		bool initialized = false;
+		bool deferred = false;
 		std::vector<Layer> layers;
+		std::vector<PendingChange> pending;
+		// Guards the queue while objects are updated in parallel
+		std::mutex pending_mutex;
+		MotionStore motion;
+		std::vector<Object*> parallel_objects;
+
+		struct DrawItem
+		{
+			int z;
+			Renderer::BlendMode blend;
+			const void* texture;
+			Object* object;
+		};
+		std::vector<DrawItem> render_queue;
+
+		struct HierarchyItem
+		{
+			Object* object;
+			bool parent_moved;
+		};
+		std::vector<HierarchyItem> hierarchy_queue;
+
+		void apply_add(const std::shared_ptr<Object>& obj, int layer);
+		void apply_remove(Object& obj, int layer);
+		void update_parallel(Layer& layer, float delta_time);
+		// Set the world transforms of the objects with a parent, see Object::set_parent()
+		void update_hierarchy();
+		void render_objects(Layer& layer, Rect view, float delta_time);
+		void render_sorted(Layer& layer, Rect view, float delta_time);
+		// Returns false if the layer can't be cached and has to be drawn directly
+		bool render_cached(Layer& layer, Rect view, float delta_time);
+		std::shared_ptr<Object>* get_stored(Layer& layer, Object& obj);
+		static bool in_region(const Object& obj, Rect region);
 	};
 
 	// TODO: move camera to be a part of the Scene objects
@@ -118,9 +271,19 @@ namespace Sputnik
 		float get_width() const;
 		float get_height() const;
 
+		// Bounding box of the playfield area seen through the camera,
+		// rotation and zoom included
+		Rect get_visible_rect() const;
+
+		// Maps playfield points to surface points. Renderers build it once
+		// in IRenderer::apply_camera() from their own surface size.
+		Transform2D get_transform() const;
+		Transform2D get_transform(Vector2 surface_size) const;
+
 		// These two are useful mostly for renderers
 		float offset_x() const;
 		float offset_y() const;
+		Vector2 get_offset(Vector2 surface_size) const;
 
 		void reset();
 
@@ -128,6 +291,10 @@ namespace Sputnik
 		static Camera& get();
 		// Change current camera and return the previous one
 		static Camera set(const Camera& camera);
+
+	private:
+		// Left and top edges, the surface size is only queried once by the callers
+		Vector2 get_top_left(Vector2 surface_size) const;
 	};
 
 	class BackgroundHandler
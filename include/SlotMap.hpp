@@ -0,0 +1,203 @@
+#ifndef __SLOTMAP_H__
+#define __SLOTMAP_H__
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+namespace Sputnik
+{
+	namespace Utils
+	{
+		/*
+			A stable handle to a value stored in a SlotMap.
+			The generation makes handles to erased values invalid
+			even after their slot is reused.
+		*/
+		struct SlotHandle
+		{
+			static constexpr uint32_t INVALID = UINT32_MAX;
+
+			uint32_t index = INVALID;
+			uint32_t generation = 0;
+
+			bool is_valid() const { return index != INVALID; }
+
+			bool operator == (const SlotHandle& h) const
+			{
+				return index == h.index && generation == h.generation;
+			}
+
+			bool operator != (const SlotHandle& h) const { return !(*this == h); }
+		};
+
+		/*
+			Dense, generation-checked container.
+
+			Values are kept contiguously in insertion order, so iterating
+			them is cache-friendly. Insertion and erasing through a handle
+			are O(1): erased values are only marked as dead and stay
+			in place until compact() is called, which keeps iteration safe
+			while values are being erased and preserves the order of the rest.
+		*/
+		template<typename T>
+		class SlotMap
+		{
+		public:
+			using Handle = SlotHandle;
+
+			Handle insert(const T& value)
+			{
+				uint32_t slot;
+				if (!free_slots.empty())
+				{
+					slot = free_slots.back();
+					free_slots.pop_back();
+				}
+				else
+				{
+					slot = (uint32_t)slots.size();
+					slots.push_back(Slot{});
+				}
+
+				slots[slot].dense = (uint32_t)values.size();
+				values.push_back(value);
+				dense_to_slot.push_back(slot);
+				alive_count++;
+
+				Handle handle;
+				handle.index = slot;
+				handle.generation = slots[slot].generation;
+				return handle;
+			}
+
+			// Returns false if the handle is already invalid
+			bool erase(Handle handle)
+			{
+				if (!contains(handle))
+					return false;
+
+				Slot& slot = slots[handle.index];
+				dense_to_slot[slot.dense] = SlotHandle::INVALID;
+				slot.dense = SlotHandle::INVALID;
+				slot.generation++;
+				free_slots.push_back(handle.index);
+
+				alive_count--;
+				dead_count++;
+				return true;
+			}
+
+			bool contains(Handle handle) const
+			{
+				return handle.index < slots.size()
+					&& slots[handle.index].generation == handle.generation
+					&& slots[handle.index].dense != SlotHandle::INVALID;
+			}
+
+			T* get(Handle handle)
+			{
+				return contains(handle) ? &values[slots[handle.index].dense] : nullptr;
+			}
+
+			const T* get(Handle handle) const
+			{
+				return contains(handle) ? &values[slots[handle.index].dense] : nullptr;
+			}
+
+			// Remove dead values, keeping the order of the alive ones
+			void compact()
+			{
+				if (dead_count == 0)
+					return;
+
+				size_t out = 0;
+				for (size_t i = 0; i < values.size(); i++)
+				{
+					uint32_t slot = dense_to_slot[i];
+					if (slot == SlotHandle::INVALID)
+						continue;
+
+					if (out != i)
+					{
+						values[out] = std::move(values[i]);
+						dense_to_slot[out] = slot;
+					}
+					slots[slot].dense = (uint32_t)out;
+					out++;
+				}
+
+				values.resize(out);
+				dense_to_slot.resize(out);
+				dead_count = 0;
+			}
+
+			void clear()
+			{
+				values.clear();
+				dense_to_slot.clear();
+				free_slots.clear();
+				for (uint32_t i = 0; i < slots.size(); i++)
+				{
+					slots[i].generation++;
+					slots[i].dense = SlotHandle::INVALID;
+					free_slots.push_back(i);
+				}
+				alive_count = 0;
+				dead_count = 0;
+			}
+
+			/*
+				Call func for every alive value in insertion order.
+				func may insert or erase values: inserted values are
+				visited in the same pass and erased values are skipped.
+				An insert can move the values, so func must not use
+				its reference after inserting.
+			*/
+			template<typename F>
+			void for_each(F func)
+			{
+				for (size_t i = 0; i < values.size(); i++)
+					if (dense_to_slot[i] != SlotHandle::INVALID)
+						func(values[i]);
+			}
+
+			template<typename F>
+			void for_each(F func) const
+			{
+				for (size_t i = 0; i < values.size(); i++)
+					if (dense_to_slot[i] != SlotHandle::INVALID)
+						func(values[i]);
+			}
+
+			// Number of alive values
+			size_t size() const { return alive_count; }
+			bool empty() const { return alive_count == 0; }
+
+			// Dense storage access; dead values are included until compact()
+			size_t dense_size() const { return values.size(); }
+			bool is_alive_at(size_t dense_index) const
+			{
+				return dense_to_slot[dense_index] != SlotHandle::INVALID;
+			}
+			T& at_dense(size_t dense_index) { return values[dense_index]; }
+			const T& at_dense(size_t dense_index) const { return values[dense_index]; }
+
+		private:
+			struct Slot
+			{
+				uint32_t dense = SlotHandle::INVALID;
+				uint32_t generation = 0;
+			};
+
+			std::vector<T> values;
+			std::vector<uint32_t> dense_to_slot;
+			std::vector<Slot> slots;
+			std::vector<uint32_t> free_slots;
+			size_t alive_count = 0;
+			size_t dead_count = 0;
+		};
+	}
+}
+#endif // __SLOTMAP_H__
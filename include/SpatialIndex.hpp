@@ -0,0 +1,202 @@
+#ifndef __SPATIALINDEX_H__
+#define __SPATIALINDEX_H__
+
+#include "Vector2.hpp"
+#include "Animation.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+namespace Sputnik
+{
+	class Object;
+
+	/*
+		Spatial hash of objects keyed on their bounds (Object::get_cached_bounds()).
+
+		The world is split into square cells of a fixed size and every
+		object is stored in all the cells its bounds touch. Objects are
+		only moved between cells when their cell range changes.
+		Queries don't allocate memory and don't write to the index, so they
+		can run on several threads at once (e.g. from parallel updates)
+		while nothing is inserted, removed or updated.
+	*/
+	class SpatialIndex
+	{
+	public:
+		explicit SpatialIndex(float cell_size = 64.f);
+
+		float get_cell_size() const { return cell_size; }
+		size_t size() const { return entries.size(); }
+
+		void insert(Object& obj);
+		void remove(Object& obj);
+		// Re-bucket the object if its bounds moved to other cells
+		void update(Object& obj);
+		void clear();
+
+		// Call func(Object&) once for every object whose bounds intersect the rectangle
+		template<typename F>
+		void query_rect(Rect rect, F func) const
+		{
+			for_each_entry(rect, [&](const Entry& e) {
+				if (e.bounds.intersects(rect))
+					func(*e.object);
+				});
+		}
+
+		// Call func(Object&) once for every object whose bounds touch the circle
+		template<typename F>
+		void query_radius(Vector2 centre, float radius, F func) const
+		{
+			Rect rect = { centre.x - radius, centre.y - radius, radius * 2, radius * 2 };
+			for_each_entry(rect, [&](const Entry& e) {
+				if (distance_to_bounds(e.bounds, centre) <= radius)
+					func(*e.object);
+				});
+		}
+
+		// Object with the closest position that passes the filter
+		// (a function accepting Object&), nullptr if none is within max_distance
+		template<typename F>
+		Object* nearest(Vector2 point, float max_distance, F filter) const
+		{
+			if (entries.empty())
+				return nullptr;
+
+			Object* best = nullptr;
+			float best_distance = max_distance;
+			int cx = cell_coord(point.x);
+			int cy = cell_coord(point.y);
+
+			// Rings that don't touch the occupied cells are skipped
+			int min_ring = std::max({ occupied.x0 - cx, cx - occupied.x1, occupied.y0 - cy, cy - occupied.y1, 0 });
+			int max_ring = std::max({ cx - occupied.x0, occupied.x1 - cx, cy - occupied.y0, occupied.y1 - cy });
+			float distance_rings = std::ceil(max_distance / cell_size) + 1;
+			if (distance_rings < max_ring)
+				max_ring = (int)distance_rings;
+
+			for (int ring = min_ring; ring <= max_ring; ring++)
+			{
+				int y0 = std::max(cy - ring, occupied.y0);
+				int y1 = std::min(cy + ring, occupied.y1);
+				int x0 = std::max(cx - ring, occupied.x0);
+				int x1 = std::min(cx + ring, occupied.x1);
+
+				for (int y = y0; y <= y1; y++)
+				{
+					// Only the border of the ring, the inside was already searched
+					bool edge_row = y == cy - ring || y == cy + ring;
+					int step = edge_row || ring == 0 ? 1 : ring * 2;
+
+					for (int x = edge_row ? x0 : cx - ring; x <= x1; x += step)
+					{
+						if (x < x0)
+							continue;
+
+						auto it = cells.find(get_key(x, y));
+						if (it == cells.end())
+							continue;
+
+						for (Entry* e : it->second)
+						{
+							// Only checked in the cell of its position, it's in every ring once
+							if (cell_coord(e->position.x) != x || cell_coord(e->position.y) != y)
+								continue;
+
+							float distance = e->position.distance_to(point);
+							if (distance <= best_distance && filter(*e->object))
+							{
+								best = e->object;
+								best_distance = distance;
+							}
+						}
+					}
+				}
+
+				// Everything further than this ring is at least this far away
+				if (best && best_distance <= ring * cell_size)
+					break;
+			}
+
+			return best;
+		}
+
+		Object* nearest(Vector2 point, float max_distance) const
+		{
+			return nearest(point, max_distance, [](Object&) { return true; });
+		}
+
+	private:
+		struct CellRange
+		{
+			int x0, y0, x1, y1;
+
+			bool operator == (const CellRange& r) const
+			{
+				return x0 == r.x0 && y0 == r.y0 && x1 == r.x1 && y1 == r.y1;
+			}
+		};
+
+		struct Entry
+		{
+			Object* object;
+			Rect bounds;
+			Vector2 position;
+			CellRange range;
+		};
+
+		float cell_size;
+		std::unordered_map<uint64_t, std::vector<Entry*>> cells;
+		// Node-based, so the entry pointers in the cells stay valid
+		std::unordered_map<const Object*, Entry> entries;
+		// Cells that had entries since the index was last empty,
+		// only valid while entries isn't empty
+		CellRange occupied = { 0, 0, 0, 0 };
+
+		int cell_coord(float v) const { return (int)std::floor(v / cell_size); }
+		CellRange get_range(Rect rect) const;
+		CellRange get_range(const Entry& e) const;
+
+		void add_to_cells(Entry& e);
+		void remove_from_cells(Entry& e);
+		void read_object(Entry& e);
+
+		static uint64_t get_key(int x, int y)
+		{
+			return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+		}
+
+		static float distance_to_bounds(const Rect& r, Vector2 point)
+		{
+			float dx = std::fmax(std::fmax(r.x - point.x, 0.f), point.x - (r.x + r.w));
+			float dy = std::fmax(std::fmax(r.y - point.y, 0.f), point.y - (r.y + r.h));
+			return std::sqrt(dx * dx + dy * dy);
+		}
+
+		// Visit every entry in the cells the rectangle touches, once
+		template<typename F>
+		void for_each_entry(Rect rect, F func) const
+		{
+			CellRange range = get_range(rect);
+
+			for (int y = range.y0; y <= range.y1; y++)
+				for (int x = range.x0; x <= range.x1; x++)
+				{
+					auto it = cells.find(get_key(x, y));
+					if (it == cells.end())
+						continue;
+
+					// An entry in several cells is only visited in the first
+					// of them that the rectangle touches
+					for (const Entry* e : it->second)
+						if (x == std::max(e->range.x0, range.x0) && y == std::max(e->range.y0, range.y0))
+							func(*e);
+				}
+		}
+	};
+}
+#endif // __SPATIALINDEX_H__
@@ -0,0 +1,104 @@
+#ifndef __TEXTURELOADER_H__
+#define __TEXTURELOADER_H__
+
+#include "Renderer.hpp"
+#include "Resource.hpp"
+
+#include <memory>
+#include <string>
+
+namespace Sputnik
+{
+	/*
+		Texture that is being loaded by TextureLoader.
+		It's empty until is_ready() is true, check it before drawing.
+	*/
+	class AsyncTexture
+	{
+	public:
+		// Uploaded or failed
+		bool is_ready() const { return ready; }
+		bool has_failed() const { return ready && !texture.is_loaded(); }
+
+		Texture& get() { return texture; }
+		const Texture& get() const { return texture; }
+
+	private:
+		Texture texture;
+		bool ready = false;
+
+		friend void finish_async_texture(AsyncTexture& target, Texture&& texture);
+	};
+
+	/*
+		Image decoded off the main thread, used by TextureLoader and
+		AssetPreloader. The texture is shared through TextureCache like
+		Texture::load_shared_from_file(), so an image that is cached
+		already is never decoded again.
+
+		Without SDL_image the image is loaded by upload().
+	*/
+	class DecodedImage
+	{
+	public:
+		explicit DecodedImage(const char* filename);
+		// The resource must be a graphics resource
+		explicit DecodedImage(Resource::Handle resource);
+		~DecodedImage();
+
+		DecodedImage(const DecodedImage&) = delete;
+		DecodedImage& operator = (const DecodedImage&) = delete;
+
+		// Nothing to decode, checked on the main thread before queuing decode()
+		bool is_cached() const;
+		// Read and decode the image, thread-safe
+		void decode();
+		// Create the texture or take the cached one, on the main thread.
+		// Decodes the image first if decode() wasn't called.
+		void upload(Texture& target);
+
+	private:
+		std::string name;
+		std::string key;
+		Resource::Handle resource = nullptr;
+#if SE_SDL2
+		SDL_Surface* surface = nullptr;
+		bool decoded = false;
+		// SDL errors are per thread, so the worker's one is kept for upload()
+		std::string error;
+#endif
+	};
+
+	/*
+		Decodes images on the workers of Utils::ThreadPool and uploads them
+		to the renderer on the main thread, see upload(). App uploads once
+		per frame within the budget of set_upload_budget(), so loading
+		hundreds of images doesn't stall the game loop.
+
+		The textures are shared through TextureCache, see DecodedImage.
+	*/
+	namespace TextureLoader
+	{
+		// Dropping the handle before it's ready cancels the loading
+		std::shared_ptr<AsyncTexture> load(const char* filename);
+		std::shared_ptr<AsyncTexture> load(Resource::Handle resource);
+
+		// Upload the decoded images until the time (in seconds) runs out,
+		// at least one is uploaded. Call it from the main thread.
+		// Returns the number of textures uploaded.
+		int upload(float budget);
+		// Block until everything queued is decoded and uploaded
+		void finish_all();
+		// Images waiting to be decoded or uploaded
+		size_t get_pending_count();
+
+		// Time App::update() spends on uploads every frame, in seconds
+		void set_upload_budget(float budget);
+		float get_upload_budget();
+
+		// Drop the queued images and wait for the ones being decoded, called by App::quit()
+		void quit();
+	}
+}
+
+#endif // __TEXTURELOADER_H__
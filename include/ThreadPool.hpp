@@ -0,0 +1,92 @@
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace Sputnik
+{
+	namespace Utils
+	{
+		/*
+			Work-stealing thread pool for data-parallel loops.
+
+			parallel_for() splits the range into chunks, deals them out to
+			per-thread queues and blocks until every chunk is processed
+			(the calling thread works too). A thread that runs out of work
+			steals chunks from the back of the other queues.
+
+			enqueue() runs background tasks such as image decoding on the
+			same threads, so the engine never has more workers than cores.
+		*/
+		class ThreadPool
+		{
+		public:
+			// 0 means one thread less than the hardware supports
+			// (the calling thread is the remaining one)
+			explicit ThreadPool(unsigned worker_count = 0);
+			~ThreadPool();
+
+			ThreadPool(const ThreadPool&) = delete;
+			ThreadPool& operator = (const ThreadPool&) = delete;
+
+			// Worker threads plus the calling thread
+			unsigned get_thread_count() const { return (unsigned)queues.size(); }
+
+			// Call func(begin, end) for chunks of [0, count).
+			// Returns after all the chunks are processed.
+			template<typename F>
+			void parallel_for(size_t count, size_t chunk_size, F func)
+			{
+				Job job = func;
+				run(count, chunk_size, job);
+			}
+
+			// Run the task on a worker later and return at once, chunks of
+			// parallel_for() go first. Without workers the task runs right away.
+			// Tasks not started when the pool is destroyed are dropped.
+			void enqueue(std::function<void()> task);
+
+			// Shared engine-wide pool
+			static ThreadPool& get();
+
+		private:
+			using Job = std::function<void(size_t, size_t)>;
+
+			struct Range
+			{
+				size_t begin, end;
+			};
+
+			struct Queue
+			{
+				std::mutex mutex;
+				std::deque<Range> ranges;
+			};
+
+			std::vector<std::thread> threads;
+			std::vector<std::unique_ptr<Queue>> queues;
+
+			std::mutex mutex;
+			std::condition_variable wake_cv;
+			std::condition_variable done_cv;
+			std::atomic<const Job*> job;
+			std::atomic<size_t> remaining;
+			std::deque<std::function<void()>> tasks;
+			size_t generation = 0;
+			bool stopping = false;
+
+			void run(size_t count, size_t chunk_size, const Job& func);
+			void work(unsigned self);
+			bool take(unsigned self, Range& range);
+			void worker_main(unsigned self);
+		};
+	}
+}
+#endif // __THREADPOOL_H__
@@ -57,7 +57,11 @@ namespace Sputnik
 		{
 			std::stringstream ss;
 			((ss << args, 0), ...);
+#if SE_SDL2
 			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Sputnik Error", ss.str().c_str(), nullptr);
+#else
+			std::cerr << "ERROR: " << ss.str() << '\n';
+#endif
 		}
 #endif
 	}
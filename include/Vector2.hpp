@@ -81,12 +81,13 @@ namespace Sputnik
 			return (*this - v).length();
 		}
 
-		// Rotate the vector clockwise
+		// Rotate the vector clockwise. Use Transform2D::rotation()
+		// to rotate many vectors by the same angle.
 		Basic_Vector rotate(float degrees) const
 		{
-			float rad = degrees * M_PI / 180.0;
-			float cos_value = cos(rad);
-			float sin_value = sin(rad);
+			float rad = degrees * (float)M_PI / 180;
+			float cos_value = std::cos(rad);
+			float sin_value = std::sin(rad);
 
 			Basic_Vector rotated_vector;
 			rotated_vector.x = x * cos_value - y * sin_value;
@@ -108,6 +109,78 @@ namespace Sputnik
 
 	using Vector2 = Basic_Vector<float>;
 	using Vector2Int = Basic_Vector<int>;
+
+	/*
+		2D affine transform, maps p to
+		{ a * p.x + c * p.y + tx, b * p.x + d * p.y + ty }.
+		A * B applies B first, then A.
+	*/
+	struct Transform2D
+	{
+		float a, b;
+		float c, d;
+		float tx, ty;
+
+		// Identity
+		Transform2D() : a(1), b(0), c(0), d(1), tx(0), ty(0) {}
+		Transform2D(float a, float b, float c, float d, float tx, float ty)
+			: a(a), b(b), c(c), d(d), tx(tx), ty(ty) {}
+
+		static Transform2D translation(Vector2 offset)
+		{
+			return { 1, 0, 0, 1, offset.x, offset.y };
+		}
+
+		// Clockwise, same as Vector2::rotate()
+		static Transform2D rotation(float degrees)
+		{
+			// Built once per transform, so it can afford double precision
+			double rad = degrees * M_PI / 180.0;
+			float cos_value = (float)std::cos(rad);
+			float sin_value = (float)std::sin(rad);
+			return { cos_value, sin_value, -sin_value, cos_value, 0, 0 };
+		}
+
+		static Transform2D scaling(Vector2 factor)
+		{
+			return { factor.x, 0, 0, factor.y, 0, 0 };
+		}
+
+		Vector2 apply(Vector2 p) const
+		{
+			return { a * p.x + c * p.y + tx, b * p.x + d * p.y + ty };
+		}
+
+		// Without the translation, for directions and sizes
+		Vector2 apply_vector(Vector2 v) const
+		{
+			return { a * v.x + c * v.y, b * v.x + d * v.y };
+		}
+
+		Transform2D operator * (const Transform2D& t) const
+		{
+			return { a * t.a + c * t.b, b * t.a + d * t.b,
+				a * t.c + c * t.d, b * t.c + d * t.d,
+				a * t.tx + c * t.ty + tx, b * t.tx + d * t.ty + ty };
+		}
+
+		// The transform must not be degenerate (e.g. scaled by 0)
+		Transform2D inverse() const
+		{
+			float det = a * d - b * c;
+			Transform2D result = { d / det, -b / det, -c / det, a / det, 0, 0 };
+			Vector2 t = result.apply_vector({ tx, ty });
+			result.tx = -t.x;
+			result.ty = -t.y;
+			return result;
+		}
+
+		// No rotation, scaling or skew
+		bool is_translation() const
+		{
+			return a == 1 && b == 0 && c == 0 && d == 1;
+		}
+	};
 	
 #undef BV_OP
 }
@@ -5,6 +5,11 @@
 #include <memory>
 #include <vector>
 #include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include <chrono>
 
 #ifdef _DEBUG
 #	include <typeinfo>
@@ -27,6 +32,10 @@
 #include "Scene.hpp"
 #include "Utils.hpp"
 #include "Fade.hpp"
+#include "Preloader.hpp"
+#include "TextureLoader.hpp"
+#include "FramePacer.hpp"
+#include "Capture.hpp"
 
 #include "platform/RenderersAll.hpp"
 
@@ -47,9 +56,8 @@ namespace Sputnik
 		void setup_exception_handler();
 		// called every frame before other engine update code
 		void handle_update();
-		// a code that runs after all update and render events
-		// should include delta_time and fps calculation events
-		void post_update(float& delta_time, float& fps);
+		// refresh rate of the display the game runs on, 0 if there's none
+		float get_display_refresh_rate();
 		// platform-specific deinitialization code
 		void platform_quit();
 
@@ -57,13 +65,29 @@ namespace Sputnik
 		namespace
 		{
 			std::unique_ptr<Renderer::IRenderer> renderer;
+			// Same as renderer if the frames are replayed on a render thread
+			Renderer::Recording_Renderer* recording_renderer = nullptr;
 			std::shared_ptr<Scene> scene;
 			std::shared_ptr<Scene> next_scene;
+			// Scene waiting for its assets, see jump_to_async()
+			std::shared_ptr<Scene> preloading_scene;
+			std::unique_ptr<AssetPreloader> preloader;
 			bool running = true;
 			float fps = 0;
+			float tick_delta = 1.f / TICK_RATE;
+			int max_ticks_per_frame = MAX_TICKS_PER_FRAME;
+			float render_alpha = 1;
+			FramePacer frame_pacer;
+			// See log_render_counters()
+			FILE* counters_log = nullptr;
+			unsigned long frame_number = 0;
+			// See SPUTNIK_GOLDEN_IMAGE in init()
+			const char* golden_image = nullptr;
+			unsigned long golden_frame = 0;
 		}
 
 		void change_scene();
+		void update_preload();
 
 		void init()
 		{
@@ -76,12 +100,21 @@ namespace Sputnik
 
 			Log::info("Setting up renderer");
 
+#if !NO_SOFTWARE_RENDERER
+			// Lets machines without a display run the game
+			const char* requested_renderer = std::getenv("SPUTNIK_RENDERER");
+			if (requested_renderer && !strcmp(requested_renderer, "software"))
+				CHECK_RENDERER(Software_Renderer);
+#endif
 #if SE_SDL_GPU
 			CHECK_RENDERER(SDL_GPU_Renderer);
 #endif
 #if SE_SDL2 && !NO_SDL2_RENDERER
 			CHECK_RENDERER(SDL2_Renderer);
 #endif
+#if !NO_SOFTWARE_RENDERER && !SE_SDL2
+			CHECK_RENDERER(Software_Renderer);
+#endif
 
 			if (!renderer)
 			{
@@ -89,16 +122,53 @@ namespace Sputnik
 				throw SputnikException("No available renderers");
 			}
 
+#if USE_RENDER_THREAD
+			if (renderer->is_feature_supported(Renderer::Feature::RENDER_THREAD))
+			{
+				recording_renderer = new Renderer::Recording_Renderer(std::move(renderer));
+				renderer.reset(recording_renderer);
+			}
+#endif
+
 			Log::info("Renderer setup: ", get_current_renderer().get_name());
 
+			// Without vsync nothing else keeps the game from running as fast as it can
+			if (FRAME_RATE_LIMIT > 0)
+				frame_pacer.set_target_rate(FRAME_RATE_LIMIT);
+			else if (!renderer->is_feature_supported(Renderer::Feature::VSYNC))
+				frame_pacer.set_target_rate(get_display_refresh_rate());
+			// Golden image run: simulate a fixed time step for SPUTNIK_GOLDEN_FRAME
+			// frames (60 by default), save the last one as PAM and quit,
+			// so the output can be compared with a reference image
+			golden_image = std::getenv("SPUTNIK_GOLDEN_IMAGE");
+			if (golden_image && *golden_image)
+			{
+				const char* frames = std::getenv("SPUTNIK_GOLDEN_FRAME");
+				golden_frame = frames ? strtoul(frames, nullptr, 10) : 60;
+				frame_pacer.set_target_rate(0);
+				Log::info("Golden image run, frame ", golden_frame, " is saved to '", golden_image, '\'');
+			}
+			else
+				golden_image = nullptr;
+
+			if (frame_pacer.get_target_rate() > 0)
+				Log::info("Frame rate limit: ", frame_pacer.get_target_rate());
+
 			Log::info("Setting up audio system");
 			Audio::init();
+#if SE_SOLOUD
 			const char* backend_string = Audio::get_engine().getBackendString();
 			Log::info("Audio backend: ", (backend_string ? backend_string : "(null)"));
+#endif
 
 			Log::info("Game-specific initialization code starts");
 			game_init();
 
+			// There's no scene to run while the first one loads
+			while (preloader && !preloader->poll())
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			update_preload();
+
 			if (!next_scene)
 			{
 				Log::error("You must call App::jump_to() in game_init()!");
@@ -115,6 +185,11 @@ namespace Sputnik
 			Log::info("Game specific deinitialization starts");
 			game_quit();
 
+			// Stop the loading threads before their targets are freed
+			preloader.reset();
+			preloading_scene.reset();
+			TextureLoader::quit();
+
 			Log::info("Quitting the last scene");
 			if (scene)
 			{
@@ -123,6 +198,12 @@ namespace Sputnik
 				scene.reset();
 			}
 
+			// The last frames keep their textures alive
+			if (recording_renderer)
+				recording_renderer->release_frames();
+			Capture::quit();
+			log_render_counters(nullptr);
+
 			Log::info("Deinitializing audio system");
 			Audio::quit();
 
@@ -138,12 +219,20 @@ namespace Sputnik
 			check_unfreed("objects", Object);
 			check_unfreed("scenes", Scene);
 
+			TextureCache::Stats cache_stats = TextureCache::get_stats();
+			Log::info("Texture cache: ", cache_stats.hits, " hits, ", cache_stats.misses, " misses");
+
+			FrameStats frame_stats = frame_pacer.get_stats();
+			Log::info("Frame time (ms): p50 ", frame_stats.p50 * 1000, ", p95 ", frame_stats.p95 * 1000,
+				", p99 ", frame_stats.p99 * 1000, ", max ", frame_stats.max * 1000);
+
 #endif
 			Log::info("Freeing resources");
 			Sputnik::Resource::remove_all();
 
 			Log::info("Deinitializing the renderer");
 			renderer.reset();
+			recording_renderer = nullptr;
 
 			Log::info("Deinitializing the rest of the engine");
 			platform_quit();
@@ -155,30 +244,72 @@ namespace Sputnik
 		{
 			float delta_time = 1 / 60.f;
 			fps = 60.f;
+			// Frame time not yet simulated
+			float accumulator = 0;
 
+			frame_pacer.start();
 			while (running)
 			{
-				Input::reset_key_pressed();
-				Input::reset_action_pressed();
-				Input::Mouse::reset();
-
 				handle_update();
 
-				game_update(delta_time);
-				Fade::update(delta_time);
+				accumulator += delta_time;
+				int ticks = 0;
+				while (accumulator >= tick_delta && ticks < max_ticks_per_frame)
+				{
+					// Object changes made during the update phase are applied
+					// in one batch before the next tick
+					scene->set_deferred(true);
+					game_update(tick_delta);
+					Fade::update(tick_delta);
+					scene->set_deferred(false);
+					scene->flush_pending();
+
+					accumulator -= tick_delta;
+					ticks++;
+
+					// Inputs are pressed for one tick only, events polled
+					// on frames without ticks wait for the next one
+					Input::reset_key_pressed();
+					Input::reset_action_pressed();
+					Input::Mouse::reset();
+				}
+
+				// Don't try to catch up forever after a long stall
+				if (ticks == max_ticks_per_frame && accumulator > tick_delta)
+					accumulator = 0;
+
+				render_alpha = accumulator / tick_delta;
+
+				update_preload();
+				TextureLoader::upload(TextureLoader::get_upload_budget());
 
 				get_current_renderer().start_drawing();
 
 				Camera::get().apply();
 				game_render(delta_time);
 				Fade::render();
+				Capture::capture_frame(get_current_renderer());
+				if (golden_image && frame_number == golden_frame)
+				{
+					Capture::screenshot(get_current_renderer(), golden_image, Capture::Format::PAM);
+					close();
+				}
 
 				get_current_renderer().end_drawing();
 
+				if (counters_log)
+					fprintf(counters_log, "%lu,%s\n", frame_number,
+						Renderer::to_csv(get_current_renderer().get_counters()).c_str());
+				frame_number++;
+
 				if (next_scene)
 					change_scene();
 
-				post_update(delta_time, fps);
+				frame_pacer.wait();
+				delta_time = frame_pacer.end_frame();
+				if (golden_image)
+					delta_time = tick_delta;
+				fps = 1 / delta_time;
 			}
 		}
 
@@ -209,11 +340,45 @@ namespace Sputnik
 			Log::info("Scene ", scene.get(), " (", typeid(*scene).name(), ") init");
 		}
 
+		void update_preload()
+		{
+			if (!preloader || !preloader->poll())
+				return;
+
+			Log::info("Scene ", preloading_scene.get(), " (", typeid(*preloading_scene).name(), ") preloaded");
+			next_scene = preloading_scene;
+			preloading_scene.reset();
+			preloader.reset();
+		}
+
 		void jump_to(const std::shared_ptr<Scene>& s)
 		{
+			preloader.reset();
+			preloading_scene.reset();
 			next_scene = s;
 		}
 
+		void jump_to_async(const std::shared_ptr<Scene>& s)
+		{
+			preloader.reset();
+			next_scene = nullptr;
+
+			preloading_scene = s;
+			preloader = Utils::make_unique<AssetPreloader>();
+			s->preload(*preloader);
+			preloader->start();
+		}
+
+		bool is_preloading()
+		{
+			return preloader != nullptr;
+		}
+
+		float get_preload_progress()
+		{
+			return preloader ? preloader->get_progress() : 1.f;
+		}
+
 		const std::shared_ptr<Scene>& get_current_scene()
 		{
 			return scene;
@@ -236,7 +401,83 @@ namespace Sputnik
 
 		float get_fps_coef()
 		{
-			return 60 / fps;
+			return 60 * tick_delta;
+		}
+
+		void set_frame_rate_limit(float rate)
+		{
+			frame_pacer.set_target_rate(rate);
+		}
+
+		float get_frame_rate_limit()
+		{
+			return frame_pacer.get_target_rate();
+		}
+
+		float get_frame_time()
+		{
+			return frame_pacer.get_raw_delta();
+		}
+
+		FrameStats get_frame_stats()
+		{
+			return frame_pacer.get_stats();
+		}
+
+		void reset_frame_stats()
+		{
+			frame_pacer.reset_stats();
+		}
+
+		bool log_render_counters(const char* filename)
+		{
+			if (counters_log)
+			{
+				fclose(counters_log);
+				counters_log = nullptr;
+			}
+			if (!filename)
+				return true;
+
+			counters_log = fopen(filename, "w");
+			if (!counters_log)
+			{
+				Log::error("Can't open file '", filename, "' for the render counters");
+				return false;
+			}
+
+			fprintf(counters_log, "frame,%s\n", Renderer::get_counters_csv_header());
+			return true;
+		}
+
+		void set_tick_rate(float ticks_per_second)
+		{
+			if (!(ticks_per_second > 0))
+			{
+				Log::error("App: Invalid tick rate ", ticks_per_second);
+				return;
+			}
+			tick_delta = 1 / ticks_per_second;
+		}
+
+		float get_tick_rate()
+		{
+			return 1 / tick_delta;
+		}
+
+		float get_tick_delta()
+		{
+			return tick_delta;
+		}
+
+		void set_max_ticks_per_frame(int count)
+		{
+			max_ticks_per_frame = std::max(count, 1);
+		}
+
+		float get_render_alpha()
+		{
+			return render_alpha;
 		}
 	}
 
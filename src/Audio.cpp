@@ -5,15 +5,20 @@
 #include "config.hpp"
 #include "Utils.hpp"
 
+#if SE_SOLOUD
 #include "soloud_wavstream.h"
 #include "soloud_wav.h"
+#endif
 
 #include <unordered_map>
+#include <mutex>
+#include <atomic>
 
 namespace Sputnik
 {
 	namespace Audio
 	{
+#if SE_SOLOUD
 		SoLoud::Soloud engine;
 
 		SoLoud::Soloud& get_engine()
@@ -235,7 +240,8 @@ namespace Sputnik
 		namespace Sound
 		{
 #if _DEBUG
-			static int sounds_allocated = 0;
+			// Sounds can be loaded by the scene preloader threads
+			static std::atomic<int> sounds_allocated(0);
 
 			int SFX::get_allocated_count()
 			{
@@ -251,6 +257,7 @@ namespace Sputnik
 #endif
 
 			std::unordered_map<unsigned char*, std::shared_ptr<SoLoud::AudioSource>> sfx_map;
+			std::mutex sfx_mutex;
 
 			SFX::~SFX()
 			{
@@ -266,6 +273,7 @@ namespace Sputnik
 			{
 				if (ptr)
 				{
+					std::lock_guard<std::mutex> lock(sfx_mutex);
 					auto it = sfx_map.find(buffer);
 					if (it != sfx_map.end())
 					{
@@ -304,15 +312,122 @@ namespace Sputnik
 					return { nullptr, nullptr };
 				}
 				
-				auto it = sfx_map.find(resource->get_buffer());
-				if (it != sfx_map.end())
-					return SFX(it->second, it->first);
+				{
+					std::lock_guard<std::mutex> lock(sfx_mutex);
+					auto it = sfx_map.find(resource->get_buffer());
+					if (it != sfx_map.end())
+						return SFX(it->second, it->first);
+				}
 
+				// Decode without holding the lock, another thread
+				// may have loaded the same sound in the meantime
 				std::shared_ptr<SoLoud::Wav> ptr = Utils::make_shared<SoLoud::Wav>();
 				ptr->loadMem(resource->get_buffer(), resource->get_size(), false, false);
-				sfx_map[resource->get_buffer()] = ptr;
-				return SFX(ptr, resource->get_buffer());
+
+				std::lock_guard<std::mutex> lock(sfx_mutex);
+				auto inserted = sfx_map.emplace(resource->get_buffer(), ptr);
+				return SFX(inserted.first->second, resource->get_buffer());
+			}
+		}
+#else
+		SoLoud::Soloud engine;
+
+		SoLoud::Soloud& get_engine()
+		{
+			return engine;
+		}
+
+		void init()
+		{
+			Log::info("SOUND: Built without SoLoud, audio is disabled");
+		}
+
+		void quit() {}
+
+		void stop_all() {}
+		void pause_all() {}
+		void unpause_all() {}
+
+		void set_global_filter(unsigned int /*id*/, SoLoud::Filter& /*filter*/) {}
+		void clear_global_filter(unsigned int /*id*/) {}
+
+		void set_global_volume(float /*volume*/) {}
+
+		float get_global_volume()
+		{
+			return 0;
+		}
+
+		namespace Filters
+		{
+			SoLoud::BiquadResonantFilter& get_underwater_filter()
+			{
+				static SoLoud::BiquadResonantFilter filter;
+				return filter;
+			}
+		}
+
+		namespace Music
+		{
+			SoLoud::AudioSource music_source;
+
+			void play(const char* /*filename*/, double /*loop_point*/) {}
+			void play(unsigned char* /*buffer*/, int /*size*/, double /*loop_point*/) {}
+			void play(Resource::Handle /*resource*/, double /*loop_point*/) {}
+			void play(std::unique_ptr<SoLoud::AudioSource> /*source*/) {}
+
+			void stop(double /*fade_seconds*/) {}
+			void stop_after(double /*seconds*/) {}
+			void pause() {}
+			void unpause() {}
+
+			void set_filter(unsigned int /*id*/, SoLoud::Filter& /*filter*/) {}
+			void clear_filter(unsigned int /*id*/) {}
+			void clear_filters() {}
+
+			void set_volume(float /*volume*/, double /*fade_seconds*/) {}
+			void set_speed(float /*speed*/, double /*fade_seconds*/) {}
+
+			void fade_out(double /*seconds*/, bool /*stop_after*/) {}
+			void fade_in(double /*seconds*/, bool /*stop_after*/) {}
+
+			SoLoud::handle get_handle()
+			{
+				return 0;
+			}
+
+			const SoLoud::AudioSource& get_audio_source()
+			{
+				return music_source;
+			}
+		}
+
+		namespace Sound
+		{
+			int SFX::get_allocated_count()
+			{
+				return 0;
+			}
+
+			SFX::~SFX() {}
+
+			SoLoud::handle SFX::play()
+			{
+				return 0;
+			}
+
+			void SFX::unload() {}
+
+			SFX::SFX(std::shared_ptr<SoLoud::AudioSource> ptr, unsigned char* buffer)
+				: ptr(ptr), buffer(buffer)
+			{
+			}
+
+			SFX load(Resource::Handle /*resource*/)
+			{
+				return { nullptr, nullptr };
 			}
 		}
+#endif
 	}
 }
\ No newline at end of file
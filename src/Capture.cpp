@@ -0,0 +1,368 @@
+#include "Capture.hpp"
+#include "Utils.hpp"
+
+#include <deque>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdio>
+#include <cmath>
+
+#if SE_SDL2
+#include "SDL_image.h"
+#endif
+
+namespace Sputnik
+{
+	namespace Capture
+	{
+		namespace
+		{
+			using Renderer::PixelBuffer;
+
+			// Frames that can be read back or encoded at the same time
+			constexpr int BUFFER_COUNT = 4;
+
+			// Shared by the frames of a sequence, the video file is closed
+			// when the last of them is written
+			struct Sequence
+			{
+				std::string path;
+				Format format;
+				float frame_rate;
+
+				// Y4M only, opened with the first frame
+				FILE* file = nullptr;
+				Vector2Int size;
+				std::vector<unsigned char> planes;
+
+				~Sequence()
+				{
+					if (file)
+						fclose(file);
+				}
+			};
+
+			struct Job
+			{
+				PixelBuffer* buffer = nullptr;
+				Format format = Format::PNG;
+				// Screenshots only
+				std::string filename;
+				// Sequence frames only
+				std::shared_ptr<Sequence> sequence;
+				unsigned long index = 0;
+			};
+
+			std::mutex mutex;
+			std::condition_variable condition;
+			PixelBuffer buffers[BUFFER_COUNT];
+			std::vector<PixelBuffer*> free_buffers;
+			bool buffers_created = false;
+			std::deque<Job> queue;
+			// Jobs taken by the worker
+			int encoding = 0;
+			std::thread worker;
+			bool stopping = false;
+
+			// Main thread only
+			std::shared_ptr<Sequence> sequence;
+			unsigned long captured_frames = 0;
+			unsigned long dropped_frames = 0;
+
+			bool save_pam(const char* filename, const PixelBuffer& buffer)
+			{
+				FILE* file = fopen(filename, "wb");
+				if (!file)
+				{
+					Log::error("Capture: Can't open file '", filename, "'");
+					return false;
+				}
+
+				fprintf(file, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n",
+					buffer.size.x, buffer.size.y);
+				size_t count = buffer.pixels.size();
+				bool saved = fwrite(buffer.pixels.data(), sizeof(Color), count, file) == count;
+				fclose(file);
+
+				if (!saved)
+					Log::error("Capture: Can't write file '", filename, "'");
+				return saved;
+			}
+
+			bool save_image(const char* filename, const PixelBuffer& buffer, Format format)
+			{
+#if SE_SDL2
+				if (format == Format::PNG)
+				{
+					SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(
+						const_cast<Color*>(buffer.pixels.data()), buffer.size.x, buffer.size.y,
+						32, buffer.size.x * 4, SDL_PIXELFORMAT_RGBA32);
+					if (!surface)
+					{
+						Log::error("Capture: Can't create a surface for '", filename, "': ", SDL_GetError());
+						return false;
+					}
+
+					bool saved = IMG_SavePNG(surface, filename) >= 0;
+					if (!saved)
+						Log::error("Capture: Can't save '", filename, "': ", IMG_GetError());
+					SDL_FreeSurface(surface);
+					return saved;
+				}
+#else
+				// Without SDL_image every format is saved as PAM
+				(void)format;
+#endif
+				return save_pam(filename, buffer);
+			}
+
+			// BT.601 studio range, what players assume for Y4M without a colour space tag
+			void write_y4m_frame(Sequence& video, const PixelBuffer& buffer)
+			{
+				if (!video.file)
+				{
+					video.file = fopen(video.path.c_str(), "wb");
+					if (!video.file)
+					{
+						Log::error("Capture: Can't open file '", video.path, "'");
+						return;
+					}
+
+					video.size = buffer.size;
+					fprintf(video.file, "YUV4MPEG2 W%d H%d F%d:1000 Ip A1:1 C444\n",
+						video.size.x, video.size.y, (int)std::lround(video.frame_rate * 1000));
+				}
+
+				// The video can't change its size
+				if (buffer.size.x != video.size.x || buffer.size.y != video.size.y)
+					return;
+
+				size_t count = buffer.pixels.size();
+				video.planes.resize(count * 3);
+				unsigned char* y_plane = video.planes.data();
+				unsigned char* u_plane = y_plane + count;
+				unsigned char* v_plane = u_plane + count;
+
+				for (size_t i = 0; i < count; i++)
+				{
+					int r = buffer.pixels[i].r, g = buffer.pixels[i].g, b = buffer.pixels[i].b;
+					y_plane[i] = (unsigned char)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+					u_plane[i] = (unsigned char)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+					v_plane[i] = (unsigned char)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+				}
+
+				fputs("FRAME\n", video.file);
+				fwrite(video.planes.data(), 1, video.planes.size(), video.file);
+			}
+
+			void encode(Job& job)
+			{
+				const PixelBuffer& buffer = *job.buffer;
+				if (!job.sequence)
+				{
+					save_image(job.filename.c_str(), buffer, job.format);
+					return;
+				}
+
+				if (job.format == Format::Y4M)
+				{
+					write_y4m_frame(*job.sequence, buffer);
+					return;
+				}
+
+				char filename[32];
+				snprintf(filename, sizeof(filename), "_%06lu.%s", job.index,
+					job.format == Format::PNG ? "png" : "pam");
+				save_image((job.sequence->path + filename).c_str(), buffer, job.format);
+			}
+
+			void worker_main()
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				while (true)
+				{
+					// Everything queued is written before stopping
+					condition.wait(lock, [] { return stopping || !queue.empty(); });
+					if (queue.empty())
+						return;
+
+					Job job = std::move(queue.front());
+					queue.pop_front();
+					encoding++;
+					lock.unlock();
+
+					encode(job);
+					// Closes the video after its last frame
+					job.sequence.reset();
+
+					lock.lock();
+					encoding--;
+					free_buffers.push_back(job.buffer);
+					condition.notify_all();
+				}
+			}
+
+			// nullptr if every buffer is busy and wait is false
+			PixelBuffer* acquire_buffer(bool wait)
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				if (!buffers_created)
+				{
+					for (PixelBuffer& buffer : buffers)
+						free_buffers.push_back(&buffer);
+					buffers_created = true;
+				}
+
+				// Buffers still being read back are only returned after the frame,
+				// so there's no point in waiting if the worker has nothing to do
+				if (wait)
+					condition.wait(lock, [] { return !free_buffers.empty() || (queue.empty() && encoding == 0); });
+
+				if (free_buffers.empty())
+					return nullptr;
+
+				PixelBuffer* buffer = free_buffers.back();
+				free_buffers.pop_back();
+				return buffer;
+			}
+
+			void submit(Renderer::IRenderer& renderer, Job job)
+			{
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (!worker.joinable())
+					{
+						stopping = false;
+						worker = std::thread(worker_main);
+					}
+				}
+
+				PixelBuffer* buffer = job.buffer;
+				// The renderer may finish the readback on its render thread
+				renderer.read_pixels(*buffer, [job](bool success) {
+					std::lock_guard<std::mutex> lock(mutex);
+					if (success)
+						queue.push_back(job);
+					else
+						free_buffers.push_back(job.buffer);
+					condition.notify_all();
+					});
+			}
+
+			Format check_format(Format format)
+			{
+#if !SE_SDL2
+				if (format == Format::PNG)
+				{
+					Log::warn("Capture: PNG needs SDL_image, saving as PAM");
+					return Format::PAM;
+				}
+#endif
+				return format;
+			}
+		}
+
+		bool screenshot(Renderer::IRenderer& renderer, const char* filename, Format format)
+		{
+			if (!filename || !*filename || format == Format::Y4M)
+			{
+				Log::error("Capture: Invalid screenshot file name or format");
+				return false;
+			}
+
+			Job job;
+			job.buffer = acquire_buffer(true);
+			if (!job.buffer)
+			{
+				Log::error("Capture: Too many screenshots in one frame, '", filename, "' skipped");
+				return false;
+			}
+
+			job.format = check_format(format);
+			job.filename = filename;
+			submit(renderer, std::move(job));
+			return true;
+		}
+
+		bool start_sequence(const char* path, Format format, float frame_rate)
+		{
+			stop_sequence();
+			if (!path || !*path || frame_rate <= 0)
+			{
+				Log::error("Capture: Invalid sequence path or frame rate");
+				return false;
+			}
+
+			sequence = Utils::make_shared<Sequence>();
+			sequence->path = path;
+			sequence->format = check_format(format);
+			sequence->frame_rate = frame_rate;
+			captured_frames = 0;
+			dropped_frames = 0;
+			return true;
+		}
+
+		void stop_sequence()
+		{
+			if (sequence)
+				Log::info("Capture: ", captured_frames, " frames captured, ", dropped_frames, " dropped");
+			// The queued frames keep it until they are written
+			sequence.reset();
+		}
+
+		bool is_capturing()
+		{
+			return sequence != nullptr;
+		}
+
+		unsigned long get_captured_frames()
+		{
+			return captured_frames;
+		}
+
+		unsigned long get_dropped_frames()
+		{
+			return dropped_frames;
+		}
+
+		void capture_frame(Renderer::IRenderer& renderer)
+		{
+			if (!sequence)
+				return;
+
+			Job job;
+			job.buffer = acquire_buffer(false);
+			if (!job.buffer)
+			{
+				dropped_frames++;
+				return;
+			}
+
+			job.format = sequence->format;
+			job.sequence = sequence;
+			job.index = captured_frames++;
+			submit(renderer, std::move(job));
+		}
+
+		void finish_all()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [] { return queue.empty() && encoding == 0; });
+		}
+
+		void quit()
+		{
+			stop_sequence();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			condition.notify_all();
+			if (worker.joinable())
+				worker.join();
+		}
+	}
+}
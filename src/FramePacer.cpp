@@ -0,0 +1,105 @@
+#include "FramePacer.hpp"
+
+#include "gamefiles/config.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace Sputnik
+{
+	namespace
+	{
+		// Sleeps wake up this late at worst, the rest is spent spinning
+		constexpr std::chrono::microseconds SPIN_TIME(1500);
+	}
+
+	// std::min() takes references, they need a definition before C++17
+	constexpr int FramePacer::HISTORY_SIZE;
+	constexpr int FramePacer::SMOOTHING_FRAMES;
+
+	FramePacer::FramePacer() : max_delta(MAX_FRAME_DELTA)
+	{
+		start();
+	}
+
+	void FramePacer::start()
+	{
+		frame_start = Clock::now();
+		deadline = frame_start + period;
+	}
+
+	void FramePacer::set_target_rate(float rate)
+	{
+		target_rate = rate > 0 ? rate : 0;
+		period = target_rate > 0
+			? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / target_rate))
+			: Clock::duration::zero();
+		deadline = frame_start + period;
+	}
+
+	void FramePacer::wait()
+	{
+		if (target_rate <= 0)
+			return;
+
+		Clock::time_point now = Clock::now();
+		// Too late to catch up, start over from now
+		if (now > deadline + period)
+		{
+			deadline = now;
+			return;
+		}
+
+		if (deadline - now > SPIN_TIME)
+			std::this_thread::sleep_for(deadline - now - SPIN_TIME);
+		while (Clock::now() < deadline)
+			std::this_thread::yield();
+	}
+
+	float FramePacer::end_frame()
+	{
+		Clock::time_point now = Clock::now();
+		raw_delta = std::chrono::duration<float>(now - frame_start).count();
+		frame_start = now;
+		if (target_rate > 0)
+			deadline += period;
+
+		history[history_next] = raw_delta;
+		history_next = (history_next + 1) % HISTORY_SIZE;
+		history_count = std::min(history_count + 1, HISTORY_SIZE);
+
+		recent[recent_next] = std::min(raw_delta, max_delta);
+		recent_next = (recent_next + 1) % SMOOTHING_FRAMES;
+		recent_count = std::min(recent_count + 1, SMOOTHING_FRAMES);
+
+		float sum = 0;
+		for (int i = 0; i < recent_count; i++)
+			sum += recent[i];
+		return sum / recent_count;
+	}
+
+	FrameStats FramePacer::get_stats() const
+	{
+		FrameStats stats;
+		stats.count = history_count;
+		if (history_count == 0)
+			return stats;
+
+		float sorted[HISTORY_SIZE];
+		std::copy(history, history + history_count, sorted);
+		std::sort(sorted, sorted + history_count);
+
+		auto percentile = [&](float p) { return sorted[(int)(p * (history_count - 1) + 0.5f)]; };
+		stats.p50 = percentile(0.5f);
+		stats.p95 = percentile(0.95f);
+		stats.p99 = percentile(0.99f);
+		stats.max = sorted[history_count - 1];
+		return stats;
+	}
+
+	void FramePacer::reset_stats()
+	{
+		history_count = 0;
+		history_next = 0;
+	}
+}
@@ -33,8 +33,12 @@ namespace Sputnik
 				if (btn < Button::LEFT || btn > Button::RIGHT)
 					return false;
 
+#if SE_SDL2
 				auto state = SDL_GetMouseState(nullptr, nullptr);
 				return state & SDL_BUTTON((int)btn);
+#else
+				return false;
+#endif
 			}
 
 			void set_pressed(Button btn, bool flag)
@@ -57,9 +61,13 @@ namespace Sputnik
 
 			Vector2Int get_window_position()
 			{
+#if SE_SDL2
 				Vector2Int v;
 				SDL_GetMouseState(&v.x, &v.y);
 				return v;
+#else
+				return {};
+#endif
 			}
 
 			void reset()
@@ -146,7 +154,11 @@ namespace Sputnik
 
 		bool is_key_held(PhysicalKey key)
 		{
+#if SE_SDL2
 			return SDL_GetKeyboardState(nullptr)[key];
+#else
+			return key_held[key];
+#endif
 		}
 
 		void set_key_pressed(PhysicalKey key, bool flag)
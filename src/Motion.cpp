@@ -0,0 +1,194 @@
+#include "Motion.hpp"
+
+#include "Platform.hpp"
+#include "Object.hpp"
+
+#if SE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Sputnik
+{
+	void MotionStore::add(Object& obj)
+	{
+		if (contains(obj))
+			return;
+
+		obj.motion_index = (int)owners.size();
+		owners.push_back(&obj);
+
+		pos_x.push_back(obj.position.x);
+		pos_y.push_back(obj.position.y);
+		vel_x.push_back(obj.velocity.x);
+		vel_y.push_back(obj.velocity.y);
+		acc_x.push_back(obj.acceleration.x);
+		acc_y.push_back(obj.acceleration.y);
+		synced_pos_x.push_back(obj.position.x);
+		synced_pos_y.push_back(obj.position.y);
+		synced_vel_x.push_back(obj.velocity.x);
+		synced_vel_y.push_back(obj.velocity.y);
+		synced_pass.push_back(pass);
+	}
+
+	void MotionStore::remove(Object& obj)
+	{
+		if (!contains(obj))
+			return;
+
+		// The object keeps its last integrated motion
+		sync(obj);
+
+		// Swap with the last element, the order doesn't matter here
+		size_t i = obj.motion_index;
+		size_t last = owners.size() - 1;
+
+		pos_x[i] = pos_x[last]; pos_y[i] = pos_y[last];
+		vel_x[i] = vel_x[last]; vel_y[i] = vel_y[last];
+		acc_x[i] = acc_x[last]; acc_y[i] = acc_y[last];
+		synced_pos_x[i] = synced_pos_x[last]; synced_pos_y[i] = synced_pos_y[last];
+		synced_vel_x[i] = synced_vel_x[last]; synced_vel_y[i] = synced_vel_y[last];
+		synced_pass[i] = synced_pass[last];
+		owners[i] = owners[last];
+		owners[i]->motion_index = (int)i;
+
+		pos_x.pop_back(); pos_y.pop_back();
+		vel_x.pop_back(); vel_y.pop_back();
+		acc_x.pop_back(); acc_y.pop_back();
+		synced_pos_x.pop_back(); synced_pos_y.pop_back();
+		synced_vel_x.pop_back(); synced_vel_y.pop_back();
+		synced_pass.pop_back();
+		owners.pop_back();
+
+		obj.motion_index = -1;
+	}
+
+	bool MotionStore::contains(const Object& obj) const
+	{
+		return obj.motion_index >= 0 && obj.motion_index < (int)owners.size()
+			&& owners[obj.motion_index] == &obj;
+	}
+
+	void MotionStore::clear()
+	{
+		for (Object* obj : owners)
+			obj->motion_index = -1;
+
+		pos_x.clear(); pos_y.clear();
+		vel_x.clear(); vel_y.clear();
+		acc_x.clear(); acc_y.clear();
+		synced_pos_x.clear(); synced_pos_y.clear();
+		synced_vel_x.clear(); synced_vel_y.clear();
+		synced_pass.clear();
+		owners.clear();
+	}
+
+	void MotionStore::integrate(float delta_time, float fps_coef)
+	{
+		size_t count = owners.size();
+		size_t i = 0;
+		pass++;
+
+		float* px = pos_x.data();
+		float* py = pos_y.data();
+		float* vx = vel_x.data();
+		float* vy = vel_y.data();
+		const float* ax = acc_x.data();
+		const float* ay = acc_y.data();
+
+#if SE_SSE2
+		const __m128 coef = _mm_set1_ps(fps_coef);
+		const __m128 dt = _mm_set1_ps(delta_time);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 new_vx = _mm_add_ps(_mm_loadu_ps(vx + i), _mm_mul_ps(_mm_loadu_ps(ax + i), coef));
+			__m128 new_vy = _mm_add_ps(_mm_loadu_ps(vy + i), _mm_mul_ps(_mm_loadu_ps(ay + i), coef));
+			_mm_storeu_ps(vx + i, new_vx);
+			_mm_storeu_ps(vy + i, new_vy);
+			_mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(new_vx, dt)));
+			_mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(new_vy, dt)));
+		}
+#endif
+
+		// Scalar tail (or the whole array without SSE2)
+		for (; i < count; i++)
+		{
+			vx[i] += ax[i] * fps_coef;
+			vy[i] += ay[i] * fps_coef;
+			px[i] += vx[i] * delta_time;
+			py[i] += vy[i] * delta_time;
+		}
+	}
+
+	void MotionStore::sync(Object& obj)
+	{
+		if (!contains(obj))
+			return;
+
+		size_t i = obj.motion_index;
+		if (synced_pass[i] != pass)
+		{
+			obj.previous_position = { synced_pos_x[i], synced_pos_y[i] };
+			synced_pass[i] = pass;
+		}
+
+		// Direct writes since the last sync replace the integrated values
+		if (obj.position.x != synced_pos_x[i] || obj.position.y != synced_pos_y[i])
+		{
+			pos_x[i] = obj.position.x;
+			pos_y[i] = obj.position.y;
+		}
+		else
+			obj.position = { pos_x[i], pos_y[i] };
+
+		if (obj.velocity.x != synced_vel_x[i] || obj.velocity.y != synced_vel_y[i])
+		{
+			vel_x[i] = obj.velocity.x;
+			vel_y[i] = obj.velocity.y;
+		}
+		else
+			obj.velocity = { vel_x[i], vel_y[i] };
+
+		acc_x[i] = obj.acceleration.x;
+		acc_y[i] = obj.acceleration.y;
+
+		synced_pos_x[i] = obj.position.x;
+		synced_pos_y[i] = obj.position.y;
+		synced_vel_x[i] = obj.velocity.x;
+		synced_vel_y[i] = obj.velocity.y;
+	}
+
+	void MotionStore::set_position(Object& obj, Vector2 position)
+	{
+		obj.position = position;
+		if (contains(obj))
+		{
+			pos_x[obj.motion_index] = position.x;
+			pos_y[obj.motion_index] = position.y;
+			synced_pos_x[obj.motion_index] = position.x;
+			synced_pos_y[obj.motion_index] = position.y;
+		}
+	}
+
+	void MotionStore::set_velocity(Object& obj, Vector2 velocity)
+	{
+		obj.velocity = velocity;
+		if (contains(obj))
+		{
+			vel_x[obj.motion_index] = velocity.x;
+			vel_y[obj.motion_index] = velocity.y;
+			synced_vel_x[obj.motion_index] = velocity.x;
+			synced_vel_y[obj.motion_index] = velocity.y;
+		}
+	}
+
+	void MotionStore::set_acceleration(Object& obj, Vector2 acceleration)
+	{
+		obj.acceleration = acceleration;
+		if (contains(obj))
+		{
+			acc_x[obj.motion_index] = acceleration.x;
+			acc_y[obj.motion_index] = acceleration.y;
+		}
+	}
+}
@@ -6,6 +6,8 @@
 #include <iostream>
 #include <algorithm>
 #include <limits>
+#include <cmath>
+#include <atomic>
 
 #ifdef _DEBUG
 #	include <typeinfo>
@@ -14,7 +16,8 @@
 namespace Sputnik
 {
 #ifdef _DEBUG
-	static int allocated_count = 0;
+	// Objects can be created from parallel updates
+	static std::atomic<int> allocated_count(0);
 #define ALLOCATED allocated_count++
 #define DEALLOCATED allocated_count--
 #define GET_ALLOCATED() (allocated_count)
@@ -37,6 +40,11 @@ namespace Sputnik
 
 	Object::~Object()
 	{
+		set_parent(nullptr);
+		// The children stay where they are
+		for (Object* child : children)
+			child->parent = nullptr;
+
 		Log::info("Object ", this, " freed");
 		DEALLOCATED;
 	}
@@ -47,20 +55,110 @@ namespace Sputnik
 		position += velocity * delta_time;
 	}
 
+	Vector2 Object::get_render_position() const
+	{
+		return previous_position + (position - previous_position) * App::get_render_alpha();
+	}
+
+	Rect Object::get_bounds() const
+	{
+		return { position.x, position.y, -1, -1 };
+	}
+
+	bool Object::set_parent(Object* new_parent)
+	{
+		for (Object* p = new_parent; p; p = p->parent)
+		{
+			if (p == this)
+			{
+				Log::error("Object ", this, " can't be a child of itself or of its children");
+				return false;
+			}
+		}
+
+		if (parent)
+			parent->children.erase(std::find(parent->children.begin(), parent->children.end(), this));
+
+		parent = new_parent;
+		if (parent)
+		{
+			parent->children.push_back(this);
+			mark_transform_dirty();
+		}
+		return true;
+	}
+
+	void Object::set_local_position(Vector2 position)
+	{
+		local_position = position;
+		mark_transform_dirty();
+	}
+
+	void Object::set_local_angle(float degrees)
+	{
+		local_angle = degrees;
+		mark_transform_dirty();
+	}
+
+	void Object::set_local_scale(Vector2 scale)
+	{
+		local_scale = scale;
+		mark_transform_dirty();
+	}
+
+	void Object::mark_transform_dirty()
+	{
+		transform_dirty = true;
+		// The ancestors above a marked one are marked already
+		for (Object* p = parent; p && !p->children_dirty; p = p->parent)
+			p->children_dirty = true;
+	}
+
+	bool Object::update_root_transform()
+	{
+		float degrees;
+		Vector2 scale;
+		get_rotation_scale(degrees, scale);
+		if (!transform_dirty && position.x == world_transform.tx && position.y == world_transform.ty
+			&& degrees == world_angle && scale.x == world_scale.x && scale.y == world_scale.y)
+			return false;
+
+		world_angle = degrees;
+		world_scale = scale;
+		world_transform = Transform2D::translation(position) * Transform2D::rotation(degrees)
+			* Transform2D::scaling(scale);
+		transform_dirty = false;
+		return true;
+	}
+
+	void Object::update_child_transform()
+	{
+		position = parent->world_transform.apply(local_position);
+		world_angle = parent->world_angle + local_angle;
+		world_scale = parent->world_scale * local_scale;
+		world_transform = Transform2D::translation(position) * Transform2D::rotation(world_angle)
+			* Transform2D::scaling(world_scale);
+		set_rotation_scale(world_angle, world_scale);
+		transform_dirty = false;
+	}
+
 	void Object::destroy()
 	{
-		App::get_current_scene()->remove_object(*this, layer);
+		// The object may still be queued to be added to a layer this frame
+		App::get_current_scene()->remove_object(*this,
+			pending_layer >= 0 ? pending_layer : layer);
 	}
 
 	void SpriteObject::update(float delta_time)
 	{
-		animation.update(delta_time, sprite_rect);
+		if (animation.update(delta_time, sprite_rect))
+			mark_changed();
 		Object::update(delta_time);
 	}
 
 	void SpriteObject::render(float delta_time)
 	{
-		auto pos = position.floor();
+		auto pos = get_render_position().floor();
 
 		if (sprite_rect.is_valid())
 		{
@@ -76,23 +174,52 @@ namespace Sputnik
 		}
 	}
 
-	void TileMapObject::render(float delta_time)
+	Rect SpriteObject::get_bounds() const
 	{
-		// TODO: use position of the object
-		int left = (int)(Camera::get().get_left() / tile_width);
-		int right = (int)(Camera::get().get_right() / tile_width) + 1;
-		int top = (int)(Camera::get().get_up() / tile_height);
-		int bottom = (int)(Camera::get().get_down() / tile_height) + 1;
+		Vector2 size;
+		if (sprite_rect.is_valid())
+			size = sprite_rect.get_size();
+		else if (sprite.is_loaded())
+			size = sprite.get_size().convert_to<float>();
+		else
+			return Object::get_bounds();
+
+		Vector2 half = size * scale / 2;
+		half = { std::fabs(half.x), std::fabs(half.y) };
 
-		if ((int)Camera::get().angle % 90 != 0)
+		if (angle != 0)
 		{
-			int zoom = (int)(1.0f / Camera::get().zoom);
-			left -= zoom;
-			right += zoom;
-			top -= zoom;
-			bottom += zoom;
+			if (angle != bounds_angle)
+			{
+				float rad = angle * M_PI / 180.0;
+				bounds_sin = std::fabs(std::sin(rad));
+				bounds_cos = std::fabs(std::cos(rad));
+				bounds_angle = angle;
+			}
+
+			// Bounding box of the rotated sprite
+			half = { half.x * bounds_cos + half.y * bounds_sin,
+				half.x * bounds_sin + half.y * bounds_cos };
 		}
 
+		return { position.x - half.x, position.y - half.y, half.x * 2, half.y * 2 };
+	}
+
+	void TileMapObject::render(float delta_time)
+	{
+		// Nothing to draw if the tileset image failed to load,
+		// check_collision() skips the missing tiles too
+		if (get_tile_count() == 0)
+			return;
+
+		// TODO: use position of the object
+		// Rotation and zoom included
+		Rect view = Camera::get().get_visible_rect();
+		int left = (int)std::floor(view.x / tile_width);
+		int right = (int)((view.x + view.w) / tile_width) + 1;
+		int top = (int)std::floor(view.y / tile_height);
+		int bottom = (int)((view.y + view.h) / tile_height) + 1;
+
 		if (left < 0)
 			left = 0;
 		if (right > (int)horizontal_tiles)
@@ -102,6 +229,24 @@ namespace Sputnik
 		if (bottom > (int)vertical_tiles)
 			bottom = vertical_tiles;
 
+		if (!use_chunks || !render_chunks(left, top, right, bottom))
+			render_tiles(left, top, right, bottom);
+
+#if SE_DEBUG_COLLISIONS
+		for (int y = top; y < bottom; y++)
+		{
+			for (int x = left; x < right; x++)
+			{
+				Tile id = get_tile(x, y);
+				if (id != 0)
+					get_tile_collision(id).debug_render({ (float)x * tile_width, (float)y * tile_height });
+			}
+		}
+#endif
+	}
+
+	void TileMapObject::render_tiles(int left, int top, int right, int bottom)
+	{
 		for (int y = top; y < bottom; y++)
 		{
 			for (int x = left; x < right; x++)
@@ -112,18 +257,104 @@ namespace Sputnik
 					continue;
 
 				render_tile(id, x, y);
-#if SE_DEBUG_COLLISIONS
-				get_tile_collision(id).debug_render({ (float)x * tile_width, (float)y * tile_height });
-#endif
 			}
 		}
 	}
 
+	bool TileMapObject::render_chunks(int left, int top, int right, int bottom)
+	{
+		if (left >= right || top >= bottom)
+			return true;
+
+		Renderer::IRenderer& renderer = get_current_renderer();
+		if (chunks.empty() || !renderer.is_feature_supported(Renderer::Feature::RENDER_TARGET))
+			return false;
+
+		int cx_begin = left / CHUNK_TILES, cx_end = (right - 1) / CHUNK_TILES;
+		int cy_begin = top / CHUNK_TILES, cy_end = (bottom - 1) / CHUNK_TILES;
+
+		// Chunks are drawn without the camera
+		bool camera_enabled = renderer.is_camera_enabled();
+		bool redrawn = false;
+		bool ok = true;
+		for (int cy = cy_begin; cy <= cy_end && ok; cy++)
+		{
+			for (int cx = cx_begin; cx <= cx_end && ok; cx++)
+			{
+				Chunk& chunk = chunks[cy * chunks_h + cx];
+				if (chunk.dirty)
+				{
+					ok = redraw_chunk(chunk, cx, cy);
+					redrawn = true;
+				}
+			}
+		}
+
+		if (redrawn)
+		{
+			renderer.reset_render_target();
+			renderer.enable_camera(camera_enabled);
+		}
+		if (!ok)
+			return false;
+
+		for (int cy = cy_begin; cy <= cy_end; cy++)
+		{
+			for (int cx = cx_begin; cx <= cx_end; cx++)
+			{
+				const Texture& texture = chunks[cy * chunks_h + cx].texture;
+				Vector2 pos = { (float)cx * CHUNK_TILES * tile_width + texture.get_width() / 2.f,
+					(float)cy * CHUNK_TILES * tile_height + texture.get_height() / 2.f };
+				renderer.draw_texture(texture, pos);
+			}
+		}
+		return true;
+	}
+
+	bool TileMapObject::redraw_chunk(Chunk& chunk, int cx, int cy)
+	{
+		Renderer::IRenderer& renderer = get_current_renderer();
+		int x0 = cx * CHUNK_TILES, y0 = cy * CHUNK_TILES;
+		int x1 = std::min(x0 + CHUNK_TILES, (int)horizontal_tiles);
+		int y1 = std::min(y0 + CHUNK_TILES, (int)vertical_tiles);
+
+		if (!chunk.texture.is_loaded())
+		{
+			chunk.texture.create((x1 - x0) * tile_width, (y1 - y0) * tile_height, true);
+			chunk.texture.set_scale_mode(image.get_scale_mode());
+			// Render targets may be created without blending
+			chunk.texture.set_blend_mode(Renderer::BlendMode::NORMAL);
+		}
+
+		if (!renderer.set_render_target(chunk.texture))
+		{
+			Log::warn("TileMapObject: Can't render to the chunk, drawing the tiles directly");
+			use_chunks = false;
+			return false;
+		}
+
+		renderer.enable_camera(false);
+		renderer.clear(Colors::NONE);
+
+		render_origin = { (float)x0 * tile_width, (float)y0 * tile_height };
+		render_tiles(x0, y0, x1, y1);
+		render_origin = { 0, 0 };
+
+		chunk.dirty = false;
+		return true;
+	}
+
+	Rect TileMapObject::get_bounds() const
+	{
+		// The map is always rendered from the playfield origin
+		return { 0, 0, (float)horizontal_tiles * tile_width, (float)vertical_tiles * tile_height };
+	}
+
 	void TileMapObject::render_tile(Tile id, int x, int y)
 	{
 		id--;
 		Rect src_rect = get_tile_rect(id);
-		Vector2 pos = { (x + 0.5f) * tile_width * 1.f, (y + 0.5f) * tile_height * 1.f };
+		Vector2 pos = Vector2{ (x + 0.5f) * tile_width * 1.f, (y + 0.5f) * tile_height * 1.f } - render_origin;
 
 		get_current_renderer().draw_texture_part(image, pos, src_rect);
 	}
@@ -169,6 +400,11 @@ namespace Sputnik
 		}
 		else
 			tile_data = std::shared_ptr<Tile[]>(data, [](Tile* p) {});
+
+		int chunks_v = (vertical_tiles + CHUNK_TILES - 1) / CHUNK_TILES;
+		chunks_h = (horizontal_tiles + CHUNK_TILES - 1) / CHUNK_TILES;
+		chunks.clear();
+		chunks.resize((size_t)chunks_h * chunks_v);
 	}
 
 	Collision::Group& TileMapObject::get_tile_collision(Tile tile)
@@ -186,19 +422,42 @@ namespace Sputnik
 		Vector2 tile_pos = { std::floor(p.x / tile_width), std::floor(p.y / tile_height) };
 		Vector2 offset = p - Vector2{tile_pos.x* tile_width, tile_pos.y* tile_height};
 		Tile tile = get_tile((int)tile_pos.x, (int)tile_pos.y);
-		if (tile)
+		if (tile && tile <= tile_collisions.size())
 			return get_tile_collision(tile).check_at(offset);
 		return false;
 	}
 
 	TileMapObject::Tile TileMapObject::get_tile(int x, int y)
 	{
-		if (x >= (int)horizontal_tiles || y >= (int)vertical_tiles)
+		if (x < 0 || y < 0 || x >= (int)horizontal_tiles || y >= (int)vertical_tiles)
 			return 0;
 		int pos = y * horizontal_tiles + x;
 		return tile_data[pos];
 	}
 
+	void TileMapObject::set_tile(int x, int y, Tile tile)
+	{
+		if (x < 0 || y < 0 || x >= (int)horizontal_tiles || y >= (int)vertical_tiles)
+		{
+			Log::warn("TileMapObject: Tile (", x, ", ", y, ") is outside the map");
+			return;
+		}
+
+		Tile& old_tile = tile_data[y * horizontal_tiles + x];
+		if (old_tile == tile)
+			return;
+		old_tile = tile;
+		chunks[(y / CHUNK_TILES) * chunks_h + x / CHUNK_TILES].dirty = true;
+		mark_changed();
+	}
+
+	void TileMapObject::invalidate()
+	{
+		for (Chunk& chunk : chunks)
+			chunk.dirty = true;
+		mark_changed();
+	}
+
 	Rect TileMapObject::get_tile_rect(Tile id)
 	{
 		int x = id % tilecount_h;
@@ -217,5 +476,6 @@ namespace Sputnik
 			image.create(1, 1);
 		}
 		tile_collisions.resize(get_tile_count());
+		invalidate();
 	}
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "PoolAllocator.hpp"
+
+#include <algorithm>
+
+namespace Sputnik
+{
+	namespace Utils
+	{
+		// Size of a slab in bytes, at least one slot is always allocated
+		static constexpr size_t SLAB_SIZE = 16 * 1024;
+
+		void* SlabPool::allocate(size_t size)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			if (requested_size == 0)
+			{
+				// Every slot has to be able to hold a free list link
+				// and keep the alignment of any fundamental type
+				const size_t align = alignof(std::max_align_t);
+				requested_size = size;
+				slot_size = std::max(size, sizeof(FreeSlot));
+				slot_size = (slot_size + align - 1) / align * align;
+				stats.slot_size = slot_size;
+			}
+			else if (size != requested_size)
+				return nullptr;
+
+			if (!free_list)
+				grow();
+
+			FreeSlot* slot = free_list;
+			free_list = slot->next;
+
+			stats.used++;
+			stats.high_water = std::max(stats.high_water, stats.used);
+			return slot;
+		}
+
+		void SlabPool::deallocate(void* ptr)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+
+			FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+			slot->next = free_list;
+			free_list = slot;
+			stats.used--;
+		}
+
+		bool SlabPool::serves(size_t size)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return requested_size == size;
+		}
+
+		PoolStats SlabPool::get_stats()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return stats;
+		}
+
+		void SlabPool::grow()
+		{
+			size_t slot_count = std::max<size_t>(1, SLAB_SIZE / slot_size);
+			std::unique_ptr<unsigned char[]> slab(new unsigned char[slot_count * slot_size]);
+
+			// Thread the new slots into the free list in address order
+			for (size_t i = slot_count; i > 0; i--)
+			{
+				FreeSlot* slot = reinterpret_cast<FreeSlot*>(slab.get() + (i - 1) * slot_size);
+				slot->next = free_list;
+				free_list = slot;
+			}
+
+			slabs.push_back(std::move(slab));
+			stats.capacity += slot_count;
+		}
+	}
+}
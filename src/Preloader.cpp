@@ -0,0 +1,135 @@
+#include "Preloader.hpp"
+#include "TextureLoader.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+
+namespace Sputnik
+{
+	namespace
+	{
+		void add_texture_job(AssetPreloader& preloader, Texture& target, std::shared_ptr<DecodedImage> image)
+		{
+			// Cached textures are taken in poll() without decoding
+			std::function<void()> load;
+			if (!image->is_cached())
+				load = [=] { image->decode(); };
+
+			preloader.custom(load, [=, &target] { image->upload(target); });
+		}
+	}
+
+	AssetPreloader::~AssetPreloader()
+	{
+		cancelled = true;
+		std::unique_lock<std::mutex> lock(loaded_mutex);
+		loaded_condition.wait(lock, [this] { return loading == 0; });
+	}
+
+	void AssetPreloader::texture(Texture& target, const char* filename)
+	{
+		add_texture_job(*this, target, Utils::make_shared<DecodedImage>(filename));
+	}
+
+	void AssetPreloader::texture(Texture& target, Resource::Handle resource)
+	{
+		if (resource == nullptr || !resource->check_type(Resource::Type::GRAPHICS))
+		{
+			// Let the usual loading code report the error
+			target.load_from_resource(resource);
+			return;
+		}
+
+		add_texture_job(*this, target, Utils::make_shared<DecodedImage>(resource));
+	}
+
+	void AssetPreloader::sound(Audio::Sound::SFX& target, Resource::Handle resource)
+	{
+		// The worker keeps the decoded sound cached until
+		// the main thread takes it from the cache
+		std::shared_ptr<std::unique_ptr<Audio::Sound::SFX>> decoded
+			= std::make_shared<std::unique_ptr<Audio::Sound::SFX>>();
+
+		custom([=] {
+			*decoded = Utils::make_unique<Audio::Sound::SFX>(Audio::Sound::load(resource));
+			},
+			[=, &target] {
+				target = Audio::Sound::load(resource);
+				decoded->reset();
+			});
+	}
+
+#if SE_TTF_AVAILABLE
+	void AssetPreloader::font(std::shared_ptr<IFont>& target, Resource::Handle resource, int ptsize)
+	{
+		custom(nullptr, [=, &target] {
+			target = Utils::make_shared<FontTTF>(resource, ptsize);
+			});
+	}
+#endif
+
+	void AssetPreloader::custom(std::function<void()> load, std::function<void()> finish)
+	{
+		jobs.push_back({ std::move(load), std::move(finish) });
+	}
+
+	void AssetPreloader::start()
+	{
+		if (started)
+			return;
+		started = true;
+
+		for (size_t i = 0; i < jobs.size(); i++)
+		{
+			// Only finish() to run, poll() takes it right away
+			if (!jobs[i].load)
+			{
+				std::lock_guard<std::mutex> lock(loaded_mutex);
+				loaded.push_back(i);
+				continue;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(loaded_mutex);
+				loading++;
+			}
+			Utils::ThreadPool::get().enqueue([this, i] { load_job(i); });
+		}
+	}
+
+	bool AssetPreloader::poll()
+	{
+		while (true)
+		{
+			size_t index;
+			{
+				std::lock_guard<std::mutex> lock(loaded_mutex);
+				if (loaded.empty())
+					break;
+				index = loaded.front();
+				loaded.pop_front();
+			}
+
+			if (jobs[index].finish)
+				jobs[index].finish();
+			finished++;
+		}
+
+		return is_ready();
+	}
+
+	float AssetPreloader::get_progress() const
+	{
+		return jobs.empty() ? 1.f : (float)finished / jobs.size();
+	}
+
+	void AssetPreloader::load_job(size_t index)
+	{
+		if (!cancelled)
+			jobs[index].load();
+
+		std::lock_guard<std::mutex> lock(loaded_mutex);
+		loaded.push_back(index);
+		loading--;
+		loaded_condition.notify_all();
+	}
+}
@@ -4,6 +4,13 @@
 #include "Exceptions.hpp"
 #include "Resource.hpp"
 #include "Utils.hpp"
+#include "Capture.hpp"
+
+#include <unordered_map>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+#include <atomic>
 
 namespace Sputnik
 {
@@ -20,6 +27,13 @@ namespace Sputnik
 
 	namespace Renderer
 	{
+		namespace
+		{
+			// Textures can be freed on the render thread
+			std::atomic<size_t> texture_memory{ 0 };
+			std::atomic<unsigned> render_target_count{ 0 };
+		}
+
 		TextureData::TextureData()
 		{
 			Log::info("Texture ", this, " loaded");
@@ -30,6 +44,121 @@ namespace Sputnik
 		{
 			Log::info("Texture ", this, " freed");
 			DEALLOCATED;
+			set_memory_usage({ 0, 0 }, false);
+		}
+
+		void TextureData::set_memory_usage(Vector2Int size, bool target)
+		{
+			texture_memory -= memory;
+			if (render_target)
+				render_target_count--;
+
+			memory = (size_t)std::max(size.x, 0) * std::max(size.y, 0) * 4;
+			render_target = target;
+
+			texture_memory += memory;
+			if (render_target)
+				render_target_count++;
+		}
+
+		const char* get_counters_csv_header()
+		{
+			return "draw_calls,textured_quads,primitives,texture_binds,blend_switches,"
+				"target_switches,pixels_filled,texture_memory,render_targets";
+		}
+
+		std::string to_csv(const FrameCounters& c)
+		{
+			return std::to_string(c.draw_calls) + ',' + std::to_string(c.textured_quads) + ','
+				+ std::to_string(c.primitives) + ',' + std::to_string(c.texture_binds) + ','
+				+ std::to_string(c.blend_switches) + ',' + std::to_string(c.target_switches) + ','
+				+ std::to_string(c.pixels_filled) + ',' + std::to_string(c.texture_memory) + ','
+				+ std::to_string(c.render_targets);
+		}
+
+		FrameCounters IRenderer::get_counters()
+		{
+			FrameCounters result = counters;
+			result.texture_memory = texture_memory;
+			result.render_targets = render_target_count;
+			return result;
+		}
+
+		bool IRenderer::take_screenshot(const char* filename)
+		{
+			return Capture::screenshot(*this, filename);
+		}
+	}
+
+	namespace TextureCache
+	{
+		static std::unordered_map<std::string, std::weak_ptr<Renderer::TextureData>> entries;
+		static Stats stats;
+
+		// Returns the cached data or loads it with the function
+		template<typename F>
+		std::shared_ptr<Renderer::TextureData> get(const std::string& key, F load)
+		{
+			auto it = entries.find(key);
+			if (it != entries.end())
+			{
+				if (auto data = it->second.lock())
+				{
+					stats.hits++;
+					return data;
+				}
+			}
+
+			stats.misses++;
+			std::shared_ptr<Renderer::TextureData> data = load();
+			if (!data)
+				return nullptr;
+
+			// Forget the textures nobody uses anymore
+			for (auto i = entries.begin(); i != entries.end();)
+			{
+				if (i->second.expired())
+					i = entries.erase(i);
+				else
+					++i;
+			}
+
+			entries[key] = data;
+			return data;
+		}
+
+		Stats get_stats()
+		{
+			Stats result = stats;
+			result.entries = std::count_if(entries.begin(), entries.end(),
+				[](const std::pair<const std::string, std::weak_ptr<Renderer::TextureData>>& entry) {
+					return !entry.second.expired();
+				});
+			return result;
+		}
+
+		void reset_stats()
+		{
+			stats.hits = 0;
+			stats.misses = 0;
+		}
+
+		std::string get_key(const char* filename)
+		{
+			return std::string("file:") + filename;
+		}
+
+		std::string get_key(Resource::Handle resource)
+		{
+			// The data is in the key, so a replaced resource is loaded again
+			return std::string("resource:") + resource->get_name() + ':'
+				+ std::to_string((uintptr_t)resource->get_buffer()) + ':' + std::to_string(resource->get_size());
+		}
+
+		bool contains(const std::string& key)
+		{
+			auto it = entries.find(key);
+			return it != entries.end() && !it->second.expired();
 		}
 	}
 
@@ -71,11 +200,45 @@ namespace Sputnik
 		load_from_buffer(resource->get_buffer(), resource->get_size());
 	}
 
+	void Texture::load_shared_from_file(const char* filename)
+	{
+		data = TextureCache::get(TextureCache::get_key(filename), [=]() {
+			return get_current_renderer().create_texture(filename);
+			});
+	}
+
+	void Texture::load_shared_from_resource(Resource::Handle resource)
+	{
+		if (resource == nullptr)
+		{
+			Log::error(SE_FUNCTION, ": resource is null");
+			return;
+		}
+
+		if (!resource->check_type(Resource::Type::GRAPHICS))
+		{
+			Log::error(SE_FUNCTION, ": Resource '", resource->get_name(),
+				"' is not a graphics resource (type: ", (int)resource->get_type(), ")");
+			return;
+		}
+
+		data = TextureCache::get(TextureCache::get_key(resource), [=]() {
+			return get_current_renderer().create_texture(resource->get_buffer(), resource->get_size());
+			});
+	}
+
 #if SE_SDL2
 	void Texture::load_from_SDL_surface(SDL_Surface* surface)
 	{
 		data = get_current_renderer().create_texture(surface);
 	}
+
+	void Texture::load_shared_from_SDL_surface(SDL_Surface* surface, const std::string& key)
+	{
+		data = TextureCache::get(key, [=]() {
+			return get_current_renderer().create_texture(surface);
+			});
+	}
 #endif
 	
 	Texture& Texture::operator = (Texture&& img)
@@ -4,6 +4,8 @@
 
 #include <fstream>
 #include <iostream>
+#include <cstring>
+#include <cstdint>
 
 #define LOG_PREFIX "RESOURCE: "
 
@@ -149,7 +151,7 @@ namespace Sputnik
 
 		std::string resource_name;
 		Resource::Type type = Resource::Type::UNKNOWN;
-		Sint32 resource_size = 0;
+		int32_t resource_size = 0;
 
 		while (std::getline(rp, resource_name, '\0'))
 		{
@@ -162,7 +164,7 @@ namespace Sputnik
 				return false;
 			}
 
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+#if SE_SDL2 && SDL_BYTEORDER == SDL_BIG_ENDIAN
 			resource_size = SDL_Swap32(resource_size);
 #endif
 
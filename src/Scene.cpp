@@ -3,6 +3,7 @@
 #include "Utils.hpp"
 #include "Object.hpp"
 #include "Renderer.hpp"
+#include "ThreadPool.hpp"
 
 #include <iostream>
 #include <cmath>
@@ -45,81 +46,375 @@ namespace Sputnik
 #endif
 	}
 
+	void Scene::preload(AssetPreloader& /*assets*/) {}
+
 	void Scene::returned() {}
 
 	void Scene::quit() {}
 
 	void Scene::update(float delta_time)
 	{
+		motion.integrate(delta_time, App::get_fps_coef());
+
 		for (Layer& layer : layers)
-			for (auto& obj : layer.objects)
-				obj->update(delta_time);
+		{
+			// Every layer waits for its parallel objects before moving on
+			update_parallel(layer, delta_time);
+
+			layer.objects.for_each([=](std::shared_ptr<Object>& obj) {
+				if (!obj->batched_motion && !obj->parallel_update)
+				{
+					obj->previous_position = obj->position;
+					obj->update(delta_time);
+				}
+				});
+		}
+	}
+
+	void Scene::update_parallel(Layer& layer, float delta_time)
+	{
+		// Objects per thread pool task
+		static constexpr size_t CHUNK_SIZE = 64;
+
+		parallel_objects.clear();
+		layer.objects.for_each([this](std::shared_ptr<Object>& obj) {
+			if (!obj->batched_motion && obj->parallel_update)
+				parallel_objects.push_back(obj.get());
+			});
+
+		if (parallel_objects.empty())
+			return;
+
+		// Worker threads must never change the layers directly
+		bool was_deferred = deferred;
+		deferred = true;
+
+		Object** objects = parallel_objects.data();
+		Utils::ThreadPool::get().parallel_for(parallel_objects.size(), CHUNK_SIZE,
+			[=](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+				{
+					objects[i]->previous_position = objects[i]->position;
+					objects[i]->update(delta_time);
+				}
+			});
+
+		deferred = was_deferred;
 	}
 
 	void Scene::render(float delta_time)
 	{
+		Vector2 surface_size = get_current_renderer().get_surface_size().convert_to<float>();
+		Rect camera_view = Camera::get().get_visible_rect();
+		Rect screen_view = { 0, 0, surface_size.x, surface_size.y };
+
 		for (Layer& layer : layers)
 		{
 			get_current_renderer().enable_camera(layer.follow_camera);
-			for (auto& obj : layer.objects)
-				if (obj->visible)
-					obj->render(delta_time);
+			Rect view = layer.follow_camera ? camera_view : screen_view;
+
+			if (!layer.cached || !render_cached(layer, view, delta_time))
+				render_objects(layer, view, delta_time);
 		}
 		
 		get_current_renderer().enable_camera(true);
 	}
 
+	void Scene::render_objects(Layer& layer, Rect view, float delta_time)
+	{
+		if (layer.render_order == Layer::RenderOrder::STATE_SORTED)
+		{
+			render_sorted(layer, view, delta_time);
+			return;
+		}
+
+		layer.objects.for_each([=](std::shared_ptr<Object>& obj) {
+			const Rect& bounds = obj->cached_bounds;
+			// Objects of unknown size are always rendered
+			if (obj->visible && (!bounds.is_valid() || bounds.intersects(view)))
+				obj->render(delta_time);
+			});
+	}
+
+	bool Scene::render_cached(Layer& layer, Rect view, float delta_time)
+	{
+		Renderer::IRenderer& renderer = get_current_renderer();
+		if (!renderer.is_feature_supported(Renderer::Feature::RENDER_TARGET))
+			return false;
+
+		Vector2Int size = renderer.get_surface_size();
+		if (!layer.cache.is_loaded() || layer.cache.get_width() != size.x || layer.cache.get_height() != size.y)
+		{
+			layer.cache.create(size.x, size.y, true);
+			// Render targets may be created without blending
+			layer.cache.set_blend_mode(Renderer::BlendMode::NORMAL);
+			layer.cache_dirty = true;
+		}
+
+		float angle = layer.follow_camera ? Camera::get().angle : 0;
+		if (view != layer.cache_view || angle != layer.cache_angle)
+			layer.cache_dirty = true;
+
+		layer.objects.for_each([&](std::shared_ptr<Object>& obj) {
+			bool moving = obj->position.x != obj->previous_position.x
+				|| obj->position.y != obj->previous_position.y;
+			if (moving || obj->changed || obj->visible != obj->cached_visible)
+				layer.cache_dirty = true;
+			// Moving objects are drawn between two ticks, so they are
+			// drawn once more after stopping at the final position
+			obj->changed = moving;
+			obj->cached_visible = obj->visible;
+			});
+
+		if (layer.cache_dirty)
+		{
+			if (!renderer.set_render_target(layer.cache))
+			{
+				Log::warn("Scene: Can't render to the layer cache, drawing the layer directly");
+				layer.cached = false;
+				layer.cache.free();
+				return false;
+			}
+
+			renderer.clear(Colors::NONE);
+			render_objects(layer, view, delta_time);
+			renderer.reset_render_target();
+
+			layer.cache_dirty = false;
+			layer.cache_view = view;
+			layer.cache_angle = angle;
+		}
+
+		// The cache covers the surface
+		renderer.enable_camera(false);
+		renderer.draw_texture(layer.cache, { size.x / 2.f, size.y / 2.f });
+		return true;
+	}
+
+	void Scene::render_sorted(Layer& layer, Rect view, float delta_time)
+	{
+		render_queue.clear();
+		layer.objects.for_each([&](std::shared_ptr<Object>& obj) {
+			const Rect& bounds = obj->cached_bounds;
+			if (!obj->visible || (bounds.is_valid() && !bounds.intersects(view)))
+				return;
+
+			const Texture* texture = obj->get_render_texture();
+			if (texture && texture->is_loaded())
+				render_queue.push_back({ obj->z, texture->get_blend_mode(), texture->get_id(), obj.get() });
+			else
+				render_queue.push_back({ obj->z, Renderer::BlendMode::NORMAL, nullptr, obj.get() });
+			});
+
+		// Stable, so objects with the same state keep their painter's order
+		std::stable_sort(render_queue.begin(), render_queue.end(),
+			[](const DrawItem& a, const DrawItem& b) {
+				if (a.z != b.z)
+					return a.z < b.z;
+				if (a.blend != b.blend)
+					return a.blend < b.blend;
+				return std::less<const void*>()(a.texture, b.texture);
+			});
+
+		for (DrawItem& item : render_queue)
+			item.object->render(delta_time);
+	}
+
 	void Scene::add_object(const std::shared_ptr<Object>& object, int layer)
+	{
+		if (deferred)
+		{
+			std::lock_guard<std::mutex> lock(pending_mutex);
+			object->pending_layer = layer;
+			pending.push_back({ PendingChange::Type::ADD, object.get(), object, layer });
+		}
+		else
+			apply_add(object, layer);
+	}
+
+	void Scene::add_object_unmanaged(Object& obj, int layer)
+	{
+		add_object(std::shared_ptr<Object>(&obj, [](Object* a) {}), layer);
+	}
+
+	void Scene::remove_object(const std::shared_ptr<Object>& obj, int layer)
+	{
+		remove_object(*obj, layer);
+	}
+
+	void Scene::remove_object(Object& obj, int layer)
+	{
+		if (!deferred)
+		{
+			apply_remove(obj, layer);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(pending_mutex);
+
+		// Several removals of the same object in one frame are merged
+		if (layer < 0 || obj.pending_removal)
+			return;
+
+		std::shared_ptr<Object> ref;
+		if (obj.layer == layer && layer >= 0)
+		{
+			std::shared_ptr<Object>* stored = get_stored(get_layer(layer), obj);
+			if (stored)
+				ref = *stored;
+		}
+
+		// Neither in the layer nor queued to be added there
+		if (!ref && obj.pending_layer != layer)
+			return;
+
+		obj.pending_removal = true;
+		pending.push_back({ PendingChange::Type::REMOVE, &obj, ref, layer });
+	}
+
+	void Scene::flush_pending()
+	{
+		for (PendingChange& change : pending)
+		{
+			change.object->pending_layer = -1;
+
+			if (change.type == PendingChange::Type::ADD)
+				apply_add(change.ref, change.layer);
+			else
+			{
+				change.object->pending_removal = false;
+				apply_remove(*change.object, change.layer);
+			}
+		}
+		pending.clear();
+
+		// Before the bounds, batched objects and children may have moved
+		update_hierarchy();
+
+		for (Layer& layer : layers)
+		{
+			layer.objects.compact();
+
+			layer.objects.for_each([&](std::shared_ptr<Object>& obj) {
+				Rect old_bounds = obj->cached_bounds;
+				obj->update_cached_bounds();
+				if (obj->cached_bounds != old_bounds)
+					obj->changed = true;
+				// Only the objects that moved to other cells are re-bucketed
+				if (layer.spatial_index)
+					layer.spatial_index->update(*obj);
+				});
+		}
+	}
+
+	void Scene::update_hierarchy()
+	{
+		hierarchy_queue.clear();
+		for (Layer& layer : layers)
+		{
+			layer.objects.for_each([this](std::shared_ptr<Object>& obj) {
+				// First visit after the update phase
+				if (obj->batched_motion)
+					motion.sync(*obj);
+
+				if (obj->parent || obj->children.empty())
+					return;
+
+				bool moved = obj->update_root_transform();
+				if (moved || obj->children_dirty)
+					for (Object* child : obj->children)
+						hierarchy_queue.push_back({ child, moved });
+				obj->children_dirty = false;
+				});
+		}
+
+		// Breadth-first, so every parent is done before its children.
+		// Subtrees that didn't move and have nothing dirty are skipped.
+		for (size_t i = 0; i < hierarchy_queue.size(); i++)
+		{
+			HierarchyItem item = hierarchy_queue[i];
+			Object& obj = *item.object;
+			bool moved = item.parent_moved || obj.transform_dirty;
+			if (moved)
+				obj.update_child_transform();
+
+			if (moved || obj.children_dirty)
+				for (Object* child : obj.children)
+					hierarchy_queue.push_back({ child, moved });
+			obj.children_dirty = false;
+		}
+	}
+
+	void Scene::apply_add(const std::shared_ptr<Object>& object, int layer)
 	{
 		if (object->layer >= 0)
 		{
 			// Save a reference so the object won't get destroyed
 			std::shared_ptr<Object> ptr = object;
-			get_layer(object->layer).objects.remove(object);
-			get_layer(layer).objects.push_back(ptr);
+			Layer& old_layer = get_layer(object->layer);
+			old_layer.objects.erase(object->handle);
+			old_layer.cache_dirty = true;
+			if (old_layer.spatial_index)
+				old_layer.spatial_index->remove(*ptr);
+
+			ptr->handle = get_layer(layer).objects.insert(ptr);
 
 			ptr->layer = layer;
 		}
 		else
 		{
-			get_layer(layer).objects.push_back(object);
+			object->handle = get_layer(layer).objects.insert(object);
 			object->layer = layer;
+			// New objects don't move in from the origin
+			object->reset_interpolation();
+
+			if (object->batched_motion)
+				motion.add(*object);
 		}
+
+		object->update_cached_bounds();
+		get_layer(layer).cache_dirty = true;
+		if (get_layer(layer).spatial_index)
+			get_layer(layer).spatial_index->insert(*object);
 		
 		Log::info("Object ", object.get(), " (", typeid(*object).name(), ") added to scene ", this,
 			" (", typeid(*this).name(), ", layer ", layer, ')');
 	}
 
-	void Scene::add_object_unmanaged(Object& obj, int layer)
+	void Scene::apply_remove(Object& obj, int layer)
 	{
-		add_object(std::shared_ptr<Object>(&obj, [](Object* a) {}), layer);
-	}
+		if (layer < 0 || obj.layer != layer)
+			return;
 
-	void Scene::remove_object(const std::shared_ptr<Object>& obj, int layer)
-	{
-		auto& objects = get_layer(layer).objects;
-		auto it = std::find(objects.begin(), objects.end(), obj);
-		if (it != objects.end())
+		/* The handle is only trusted if it still points to this object,
+			the object is kept alive until the layer is compacted */
+		Layer& l = get_layer(layer);
+		if (get_stored(l, obj))
 		{
-			obj->layer = -1;
-			objects.erase(it);
+			l.objects.erase(obj.handle);
+			l.cache_dirty = true;
+			if (l.spatial_index)
+				l.spatial_index->remove(obj);
+			obj.layer = -1;
+			obj.handle = {};
+			motion.remove(obj);
 		}
 	}
+	
+	std::shared_ptr<Object>* Scene::get_stored(Layer& layer, Object& obj)
+	{
+		std::shared_ptr<Object>* stored = layer.objects.get(obj.handle);
+		return stored && stored->get() == &obj ? stored : nullptr;
+	}
 
-	void Scene::remove_object(Object& obj, int layer)
+	bool Scene::in_region(const Object& obj, Rect region)
 	{
-		auto& objects = get_layer(layer).objects;
-		/* Find a std::shared_ptr to the object, and if found,
-			delete it from the scene */
-		auto it = std::find_if(objects.begin(), objects.end(),
-			[&](std::shared_ptr<Object>& o) { return o.get() == &obj; });
-		if (it != objects.end())
-		{
-			obj.layer = -1;
-			objects.erase(it);
-		}
+		Rect bounds = obj.get_cached_bounds();
+		if (!bounds.is_valid())
+			bounds = { obj.position.x, obj.position.y, 0, 0 };
+		return bounds.intersects(region);
 	}
-	
+
 	void Scene::add_layer(int id, Layer params)
 	{
 		if (id >= 0)
@@ -130,7 +425,15 @@ namespace Sputnik
 			layers.at(id) = std::move(params);
 		}
 		else
-			layers.emplace_back(params);
+			layers.emplace_back(std::move(params));
+	}
+
+	void Scene::Layer::enable_spatial_index(float cell_size)
+	{
+		spatial_index = Utils::make_unique<SpatialIndex>(cell_size);
+		objects.for_each([this](std::shared_ptr<Object>& obj) {
+			spatial_index->insert(*obj);
+			});
 	}
 
 	Scene::Layer& Scene::get_layer(int layer)
@@ -143,58 +446,115 @@ namespace Sputnik
 		get_current_renderer().apply_camera(*this);
 	}
 
+	namespace
+	{
+		Vector2 get_surface_size()
+		{
+			return get_current_renderer().get_surface_size().convert_to<float>();
+		}
+	}
+
 	// TODO: properly handle limit methods if at angle
 
+	Vector2 Camera::get_top_left(Vector2 surface_size) const
+	{
+		int w = surface_size.x / zoom;
+		int h = surface_size.y / zoom;
+		Vector2 result = { std::floor(position.x) - w / 2.0f, std::floor(position.y) - h / 2.0f };
+
+		if (xmin >= 0 && result.x < xmin)
+			result.x = xmin;
+		if (xmax >= 0 && result.x > (xmax - w / zoom)) result.x = xmax - w / zoom;
+		if (ymin >= 0 && result.y < ymin)
+			result.y = ymin;
+		if (ymax >= 0 && result.y > (ymax - h / zoom)) result.y = ymax - h / zoom;
+		return result;
+	}
+
 	float Camera::get_up() const
 	{
-		int h = get_height();
-		float yresult = floor(position.y) - h / 2.0f;
-		if (ymin >= 0 && yresult < ymin)
-			yresult = ymin;
-		if (ymax >= 0 && yresult > (ymax - h / zoom)) yresult = ymax - h / zoom;
-		return yresult;
+		return get_top_left(get_surface_size()).y;
 	}
 
 	float Camera::get_down() const
 	{
-		return get_up() + get_height();
+		Vector2 size = get_surface_size();
+		return get_top_left(size).y + size.y / zoom;
 	}
 
 	float Camera::get_left() const
 	{
-		int w = get_width();
-		float xresult = floor(position.x) - w / 2.0f;
-		if (xmin >= 0 && xresult < xmin)
-			xresult = xmin;
-		if (xmax >= 0 && xresult > (xmax - w / zoom)) xresult = xmax - w / zoom;
-		return xresult;
+		return get_top_left(get_surface_size()).x;
 	}
 
 	float Camera::get_right() const
 	{
-		return get_left() + get_width();
+		Vector2 size = get_surface_size();
+		return get_top_left(size).x + size.x / zoom;
 	}
 
 	float Camera::get_width() const
 	{
-		return get_current_renderer().get_surface_size().x / zoom;
+		return get_surface_size().x / zoom;
 	}
 
 	float Camera::get_height() const
 	{
-		return get_current_renderer().get_surface_size().y / zoom;
+		return get_surface_size().y / zoom;
+	}
+
+	Rect Camera::get_visible_rect() const
+	{
+		// The surface corners seen from the playfield, so culling
+		// matches what the renderers draw
+		Vector2 size = get_surface_size();
+		Transform2D to_playfield = get_transform(size).inverse();
+		Vector2 corners[] = {
+			to_playfield.apply({ 0, 0 }), to_playfield.apply({ size.x, 0 }),
+			to_playfield.apply({ size.x, size.y }), to_playfield.apply({ 0, size.y }),
+		};
+
+		Vector2 min = corners[0], max = corners[0];
+		for (Vector2 p : corners)
+		{
+			min = { std::min(min.x, p.x), std::min(min.y, p.y) };
+			max = { std::max(max.x, p.x), std::max(max.y, p.y) };
+		}
+		return { min.x, min.y, max.x - min.x, max.y - min.y };
+	}
+
+	Transform2D Camera::get_transform() const
+	{
+		return get_transform(get_surface_size());
+	}
+
+	Transform2D Camera::get_transform(Vector2 surface_size) const
+	{
+		Vector2 offset = get_offset(surface_size);
+		// Exact, so the renderers can snap positions to pixels
+		if (zoom == 1 && angle == 0)
+			return Transform2D::translation(-offset);
+
+		// Rotated and zoomed around the surface centre
+		Vector2 centre = surface_size / 2;
+		return Transform2D::translation(centre) * Transform2D::rotation(angle)
+			* Transform2D::scaling({ zoom, zoom }) * Transform2D::translation(-(offset + centre));
 	}
 
 	float Camera::offset_x() const
 	{
-		float w = get_current_renderer().get_surface_size().x / 2.0f;
-		return get_left() - w + w / zoom;
+		return get_offset(get_surface_size()).x;
 	}
 
 	float Camera::offset_y() const
 	{
-		float h = get_current_renderer().get_surface_size().y / 2.0f;
-		return get_up() - h + h / zoom;
+		return get_offset(get_surface_size()).y;
+	}
+
+	Vector2 Camera::get_offset(Vector2 surface_size) const
+	{
+		Vector2 half = surface_size / 2;
+		return get_top_left(surface_size) - half + half / zoom;
 	}
 
 	void Camera::reset()
@@ -218,13 +578,15 @@ namespace Sputnik
 	void BackgroundHandler::render(float delta_time)
 	{
 		auto& renderer = get_current_renderer();
+		// The camera doesn't move while the parts are drawn
+		const Camera& camera = Camera::get();
+		float left = camera.get_left(), up = camera.get_up(), right = camera.get_right();
 
 		for (Part& p : parts)
 		{
 			float xcoef = 1.f - p.xcoef;
 			float ycoef = 1.f - p.ycoef;
-			Vector2 pos = p.pos +
-				Vector2{ Camera::get().get_left() * xcoef, Camera::get().get_up() * ycoef };
+			Vector2 pos = p.pos + Vector2{ left * xcoef, up * ycoef };
 
 			// TODO: Y wrap
 			if (p.xwrap)
@@ -233,10 +595,10 @@ namespace Sputnik
 				Vector2 size = p.texture_rect.get_size();
 
 				// Left wrap
-				pos.x -= std::ceil((pos.x - Camera::get().get_left()) / size.x + 0.5f) * size.x;
+				pos.x -= std::ceil((pos.x - left) / size.x + 0.5f) * size.x;
 
 				// Right wrap
-				while (pos.x + half_size.x < Camera::get().get_right())
+				while (pos.x + half_size.x < right)
 				{
 					pos.x += size.x;
 					renderer.draw_texture_part(p.texture, pos, p.texture_rect);
@@ -0,0 +1,127 @@
+#include "SpatialIndex.hpp"
+
+#include "Object.hpp"
+
+#include <algorithm>
+
+namespace Sputnik
+{
+	SpatialIndex::SpatialIndex(float cell_size)
+		: cell_size(cell_size > 0 ? cell_size : 64.f) {}
+
+	void SpatialIndex::insert(Object& obj)
+	{
+		if (entries.count(&obj))
+		{
+			update(obj);
+			return;
+		}
+
+		Entry& e = entries[&obj];
+		e.object = &obj;
+		read_object(e);
+		e.range = get_range(e);
+		add_to_cells(e);
+	}
+
+	void SpatialIndex::remove(Object& obj)
+	{
+		auto it = entries.find(&obj);
+		if (it == entries.end())
+			return;
+
+		remove_from_cells(it->second);
+		entries.erase(it);
+	}
+
+	void SpatialIndex::update(Object& obj)
+	{
+		auto it = entries.find(&obj);
+		if (it == entries.end())
+			return;
+
+		Entry& e = it->second;
+		read_object(e);
+
+		CellRange range = get_range(e);
+		if (range == e.range)
+			return;
+
+		remove_from_cells(e);
+		e.range = range;
+		add_to_cells(e);
+	}
+
+	void SpatialIndex::clear()
+	{
+		cells.clear();
+		entries.clear();
+	}
+
+	SpatialIndex::CellRange SpatialIndex::get_range(Rect rect) const
+	{
+		return { cell_coord(rect.x), cell_coord(rect.y),
+			cell_coord(rect.x + rect.w), cell_coord(rect.y + rect.h) };
+	}
+
+	SpatialIndex::CellRange SpatialIndex::get_range(const Entry& e) const
+	{
+		// The position is included so nearest() can find the object by it
+		CellRange range = get_range(e.bounds);
+		int px = cell_coord(e.position.x);
+		int py = cell_coord(e.position.y);
+		range.x0 = std::min(range.x0, px);
+		range.y0 = std::min(range.y0, py);
+		range.x1 = std::max(range.x1, px);
+		range.y1 = std::max(range.y1, py);
+		return range;
+	}
+
+	void SpatialIndex::add_to_cells(Entry& e)
+	{
+		if (cells.empty())
+			occupied = e.range;
+		else
+		{
+			occupied.x0 = std::min(occupied.x0, e.range.x0);
+			occupied.y0 = std::min(occupied.y0, e.range.y0);
+			occupied.x1 = std::max(occupied.x1, e.range.x1);
+			occupied.y1 = std::max(occupied.y1, e.range.y1);
+		}
+
+		for (int y = e.range.y0; y <= e.range.y1; y++)
+			for (int x = e.range.x0; x <= e.range.x1; x++)
+				cells[get_key(x, y)].push_back(&e);
+	}
+
+	void SpatialIndex::remove_from_cells(Entry& e)
+	{
+		for (int y = e.range.y0; y <= e.range.y1; y++)
+			for (int x = e.range.x0; x <= e.range.x1; x++)
+			{
+				auto it = cells.find(get_key(x, y));
+				if (it == cells.end())
+					continue;
+
+				std::vector<Entry*>& cell = it->second;
+				auto found = std::find(cell.begin(), cell.end(), &e);
+				if (found != cell.end())
+				{
+					*found = cell.back();
+					cell.pop_back();
+				}
+				// Cells of moving objects would pile up otherwise
+				if (cell.empty())
+					cells.erase(it);
+			}
+	}
+
+	void SpatialIndex::read_object(Entry& e)
+	{
+		e.position = e.object->position;
+		e.bounds = e.object->get_cached_bounds();
+		// Objects of unknown size are indexed as a point
+		if (!e.bounds.is_valid())
+			e.bounds = { e.position.x, e.position.y, 0, 0 };
+	}
+}
@@ -0,0 +1,255 @@
+#include "TextureLoader.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+
+#include "gamefiles/config.hpp"
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#if SE_SDL2
+#include "SDL_image.h"
+#endif
+
+namespace Sputnik
+{
+	void finish_async_texture(AsyncTexture& target, Texture&& texture)
+	{
+		target.texture = std::move(texture);
+		target.ready = true;
+	}
+
+	DecodedImage::DecodedImage(const char* filename)
+		: name(filename), key(TextureCache::get_key(filename))
+	{
+	}
+
+	DecodedImage::DecodedImage(Resource::Handle resource)
+		: name(resource->get_name()), key(TextureCache::get_key(resource)), resource(resource)
+	{
+	}
+
+	DecodedImage::~DecodedImage()
+	{
+#if SE_SDL2
+		if (surface)
+			SDL_FreeSurface(surface);
+#endif
+	}
+
+	bool DecodedImage::is_cached() const
+	{
+		return TextureCache::contains(key);
+	}
+
+	void DecodedImage::decode()
+	{
+#if SE_SDL2
+		// Decoding to a surface is thread-safe, creating a texture is not
+		SDL_RWops* rw = resource
+			? SDL_RWFromConstMem(resource->get_buffer(), resource->get_size())
+			: SDL_RWFromFile(name.c_str(), "rb");
+		if (rw)
+			surface = IMG_Load_RW(rw, 1);
+		if (!surface)
+			error = rw ? IMG_GetError() : SDL_GetError();
+		decoded = true;
+#endif
+	}
+
+	void DecodedImage::upload(Texture& target)
+	{
+#if SE_SDL2
+		if (is_cached())
+		{
+			target.load_shared_from_SDL_surface(nullptr, key);
+			return;
+		}
+
+		if (!decoded)
+			decode();
+
+		if (!surface)
+		{
+			Log::error("Cannot load texture '", name, "': ", error);
+			return;
+		}
+
+		target.load_shared_from_SDL_surface(surface, key);
+		SDL_FreeSurface(surface);
+		surface = nullptr;
+#else
+		if (resource)
+			target.load_shared_from_resource(resource);
+		else
+			target.load_shared_from_file(name.c_str());
+#endif
+	}
+
+	namespace TextureLoader
+	{
+		namespace
+		{
+			struct Job
+			{
+				std::weak_ptr<AsyncTexture> target;
+				DecodedImage image;
+
+				explicit Job(const char* filename) : image(filename) {}
+				explicit Job(Resource::Handle resource) : image(resource) {}
+			};
+
+			std::mutex mutex;
+			std::condition_variable condition;
+			std::deque<std::unique_ptr<Job>> decode_queue;
+			std::deque<std::unique_ptr<Job>> upload_queue;
+			// Jobs taken by the pool
+			size_t decoding = 0;
+
+			float upload_budget = TEXTURE_UPLOAD_BUDGET;
+
+			// One pool task per job, it takes the oldest one
+			void decode_next()
+			{
+				std::unique_ptr<Job> job;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					// Dropped by quit()
+					if (decode_queue.empty())
+						return;
+
+					job = std::move(decode_queue.front());
+					decode_queue.pop_front();
+					decoding++;
+				}
+
+				// Nobody waits for the texture anymore
+				if (!job->target.expired())
+					job->image.decode();
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					decoding--;
+					upload_queue.push_back(std::move(job));
+				}
+				condition.notify_all();
+			}
+
+			std::shared_ptr<AsyncTexture> add_job(std::unique_ptr<Job> job)
+			{
+				std::shared_ptr<AsyncTexture> result = Utils::make_shared<AsyncTexture>();
+				job->target = result;
+
+				// Skip the pool, upload() takes the cached texture
+				bool cached = job->image.is_cached();
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					(cached ? upload_queue : decode_queue).push_back(std::move(job));
+				}
+
+				if (!cached)
+					Utils::ThreadPool::get().enqueue(decode_next);
+				return result;
+			}
+
+			void upload_job(Job& job, AsyncTexture& target)
+			{
+				Texture texture;
+				job.image.upload(texture);
+				finish_async_texture(target, std::move(texture));
+			}
+		}
+
+		std::shared_ptr<AsyncTexture> load(const char* filename)
+		{
+			return add_job(Utils::make_unique<Job>(filename));
+		}
+
+		std::shared_ptr<AsyncTexture> load(Resource::Handle resource)
+		{
+			if (resource == nullptr || !resource->check_type(Resource::Type::GRAPHICS))
+			{
+				// Let the usual loading code report the error
+				std::shared_ptr<AsyncTexture> result = Utils::make_shared<AsyncTexture>();
+				Texture texture;
+				texture.load_from_resource(resource);
+				finish_async_texture(*result, std::move(texture));
+				return result;
+			}
+
+			return add_job(Utils::make_unique<Job>(resource));
+		}
+
+		int upload(float budget)
+		{
+			using Clock = std::chrono::steady_clock;
+			Clock::time_point start = Clock::now();
+			int uploaded = 0;
+
+			while (true)
+			{
+				std::unique_ptr<Job> job;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (upload_queue.empty())
+						break;
+					job = std::move(upload_queue.front());
+					upload_queue.pop_front();
+				}
+
+				if (std::shared_ptr<AsyncTexture> target = job->target.lock())
+				{
+					upload_job(*job, *target);
+					uploaded++;
+				}
+
+				if (std::chrono::duration<float>(Clock::now() - start).count() >= budget)
+					break;
+			}
+
+			return uploaded;
+		}
+
+		void finish_all()
+		{
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					condition.wait(lock, [] {
+						return !upload_queue.empty() || (decode_queue.empty() && decoding == 0);
+						});
+					if (upload_queue.empty())
+						return;
+				}
+				upload(1e9f);
+			}
+		}
+
+		size_t get_pending_count()
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			return decode_queue.size() + decoding + upload_queue.size();
+		}
+
+		void set_upload_budget(float budget)
+		{
+			upload_budget = budget;
+		}
+
+		float get_upload_budget()
+		{
+			return upload_budget;
+		}
+
+		void quit()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			decode_queue.clear();
+			condition.wait(lock, [] { return decoding == 0; });
+			upload_queue.clear();
+		}
+	}
+}
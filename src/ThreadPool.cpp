@@ -0,0 +1,182 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace Sputnik
+{
+	namespace Utils
+	{
+		ThreadPool::ThreadPool(unsigned worker_count)
+			: job(nullptr), remaining(0)
+		{
+			if (worker_count == 0)
+			{
+				unsigned hardware = std::thread::hardware_concurrency();
+				worker_count = hardware > 1 ? hardware - 1 : 0;
+			}
+
+			// The last queue belongs to the calling thread
+			for (unsigned i = 0; i < worker_count + 1; i++)
+				queues.push_back(std::unique_ptr<Queue>(new Queue()));
+
+			for (unsigned i = 0; i < worker_count; i++)
+				threads.emplace_back(&ThreadPool::worker_main, this, i);
+		}
+
+		ThreadPool::~ThreadPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			wake_cv.notify_all();
+
+			for (std::thread& t : threads)
+				t.join();
+		}
+
+		ThreadPool& ThreadPool::get()
+		{
+			static ThreadPool pool;
+			return pool;
+		}
+
+		void ThreadPool::enqueue(std::function<void()> task)
+		{
+			if (threads.empty())
+			{
+				task();
+				return;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasks.push_back(std::move(task));
+			}
+			wake_cv.notify_one();
+		}
+
+		void ThreadPool::run(size_t count, size_t chunk_size, const Job& func)
+		{
+			if (count == 0)
+				return;
+
+			if (chunk_size == 0)
+				chunk_size = 1;
+
+			size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+
+			// Nothing to share, skip the synchronization
+			if (threads.empty() || chunk_count == 1)
+			{
+				func(0, count);
+				return;
+			}
+
+			job = &func;
+			remaining = chunk_count;
+
+			// Every queue gets a contiguous block of chunks
+			// so the threads start on separate parts of the range
+			size_t queue_count = queues.size();
+			for (size_t q = 0; q < queue_count; q++)
+			{
+				size_t first = chunk_count * q / queue_count;
+				size_t last = chunk_count * (q + 1) / queue_count;
+
+				std::lock_guard<std::mutex> lock(queues[q]->mutex);
+				for (size_t c = first; c < last; c++)
+					queues[q]->ranges.push_back({ c * chunk_size, std::min(count, (c + 1) * chunk_size) });
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				generation++;
+			}
+			wake_cv.notify_all();
+
+			work((unsigned)queue_count - 1);
+
+			std::unique_lock<std::mutex> lock(mutex);
+			done_cv.wait(lock, [this] { return remaining == 0; });
+			job = nullptr;
+		}
+
+		void ThreadPool::work(unsigned self)
+		{
+			Range range;
+			while (take(self, range))
+			{
+				(*job)(range.begin, range.end);
+
+				if (--remaining == 0)
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					done_cv.notify_all();
+				}
+			}
+		}
+
+		bool ThreadPool::take(unsigned self, Range& range)
+		{
+			// Own queue first, from the front
+			{
+				Queue& own = *queues[self];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (!own.ranges.empty())
+				{
+					range = own.ranges.front();
+					own.ranges.pop_front();
+					return true;
+				}
+			}
+
+			// Steal from the back of the others
+			size_t count = queues.size();
+			for (size_t i = 1; i < count; i++)
+			{
+				Queue& victim = *queues[(self + i) % count];
+				std::lock_guard<std::mutex> lock(victim.mutex);
+				if (!victim.ranges.empty())
+				{
+					range = victim.ranges.back();
+					victim.ranges.pop_back();
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		void ThreadPool::worker_main(unsigned self)
+		{
+			size_t seen_generation = 0;
+
+			while (true)
+			{
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					wake_cv.wait(lock, [&] {
+						return stopping || generation != seen_generation || !tasks.empty();
+						});
+					if (stopping)
+						return;
+
+					if (generation != seen_generation)
+						seen_generation = generation;
+					else
+					{
+						task = std::move(tasks.front());
+						tasks.pop_front();
+					}
+				}
+
+				if (task)
+					task();
+				else
+					work(self);
+			}
+		}
+	}
+}
@@ -9,6 +9,17 @@
 #define SURFACE_SIZE    Vector2Int{ 424, 240 }
 #define WINDOW_SIZE     (SURFACE_SIZE * 2)
 
+// Simulation ticks per second, game_update() always gets 1 / TICK_RATE
+#define TICK_RATE       60
+// Most ticks simulated in one frame, the rest is dropped when the game lags
+#define MAX_TICKS_PER_FRAME 5
+// Frames per second, 0 limits the rate only if the renderer has no vsync
+#define FRAME_RATE_LIMIT 0
+// Longest frame delta passed to game_render() in seconds
+#define MAX_FRAME_DELTA 0.25f
+// Seconds per frame spent on uploading textures loaded by TextureLoader
+#define TEXTURE_UPLOAD_BUDGET 0.004f
+
 // Audio backend for SoLoud (the enum is defined in soloud.h)
 // Check CMakeLists.txt definitions starting with "WITH_" for available backends.
 #define AUDIO_BACKEND BACKENDS::AUTO
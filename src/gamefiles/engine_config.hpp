@@ -7,6 +7,13 @@
 
 #define NO_SDL_GPU          0
 #define NO_SDL2_RENDERER    0
+// The software renderer is used when the SPUTNIK_RENDERER environment
+// variable is "software" or when no other renderer is available
+// (SPUTNIK_GOLDEN_IMAGE saves one frame of such a run, see App::init())
+#define NO_SOFTWARE_RENDERER 0
+// Record the frames and replay them on a render thread when the renderer
+// supports it, so the next frame is simulated while the last one is drawn
+#define USE_RENDER_THREAD   1
 // TODO: NO_SDL_TTF
 
 #endif // __ENGINE_CONFIG_H__
\ No newline at end of file
@@ -34,9 +34,11 @@ namespace Sputnik
 		Resource::load_resource_pack("test.srp");
 		get_window().center_window();
 
+#if SE_SDL2
 		Input::set_key_bind(SDL_SCANCODE_Z, InputActions::JUMP);
 		Input::set_key_bind(SDL_SCANCODE_X, InputActions::JUMP);
 		Input::set_key_bind(SDL_SCANCODE_C, InputActions::JUMP);
+#endif
 
 		App::jump_to<Level>();
 	}
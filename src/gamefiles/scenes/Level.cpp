@@ -114,7 +114,7 @@ GPU_Translate(-160, -120, -120);*/
 
 Player::Player()
 {
-	sprite.load_from_resource(Resource::get("SPRITE"));
+	sprite.load_shared_from_resource(Resource::get("SPRITE"));
 
 	sprite_rect = { 0,0,48,48 };
 	velocity = { 0,0 };
@@ -242,32 +242,38 @@ void Level::init()
 	get_current_renderer().set_bg_color(Colors::GRAY);
 
 	add_layer(LAYER_MAIN);
+	// Not cached, the antialiased text would be blended twice
 	add_layer(LAYER_HUD, { false });
 
 	tileset.load_image(Resource::get("TILES"));
 	tileset.load_layout(10, 3, level_layout);
-	tileset.get_tile_collision(1).add_shape(
-		Utils::make_unique<Collision::Polygon>(std::vector<Vector2>{
-			{ 0, 32 },
-			{ 40, 37 },
-			{ 90, 37 },
-			{ 128, 32 },
-			{ 128, 128 },
-			{ 0, 128 },
-	}));
-	tileset.get_tile_collision(2).add_shape(
-		Utils::make_unique<Collision::Polygon>(std::vector<Vector2>{
-			{ 0, 33 },
-			{ 56, 18 },
-			{ 105, 5 },
-			{ 128, 5 },
-			{ 128, 128 },
-			{ 0, 128 },
-	}));
+	// The tileset is empty when the PNG couldn't be decoded
+	if (tileset.get_tile_count() >= 2)
+	{
+		tileset.get_tile_collision(1).add_shape(
+			Utils::make_unique<Collision::Polygon>(std::vector<Vector2>{
+				{ 0, 32 },
+				{ 40, 37 },
+				{ 90, 37 },
+				{ 128, 32 },
+				{ 128, 128 },
+				{ 0, 128 },
+		}));
+		tileset.get_tile_collision(2).add_shape(
+			Utils::make_unique<Collision::Polygon>(std::vector<Vector2>{
+				{ 0, 33 },
+				{ 56, 18 },
+				{ 105, 5 },
+				{ 128, 5 },
+				{ 128, 128 },
+				{ 0, 128 },
+		}));
+	}
 
 	player.position = { 150, 100 };
 	Camera::get().position = player.position;
 
+#if SE_TTF_AVAILABLE
 	std::shared_ptr<FontTTF> font = Utils::make_shared<FontTTF>("times.ttf", 14);
 	{
 		std::shared_ptr<TextObjectUnicode> text = create_object<TextObjectUnicode>(
@@ -282,6 +288,7 @@ void Level::init()
 		text->position = { text->get_sprite().get_width() / 2.f + 5,
 						get_current_renderer().get_surface_size().y - text->get_sprite().get_height() / 2.f - 5 };
 	}
+#endif
 
 	add_object_unmanaged(tileset, LAYER_MAIN);
 	add_object_unmanaged(player, LAYER_MAIN);
@@ -356,6 +363,8 @@ void Level::returned()
 
 void Level::update(float delta_time)
 {
+	// Debug keys, there is no keyboard without SDL
+#if SE_SDL2
 	if (Input::is_key_held(SDL_SCANCODE_D))
 		Camera::get().angle += 2;
 	if (Input::is_key_held(SDL_SCANCODE_A))
@@ -375,22 +384,27 @@ void Level::update(float delta_time)
 		water_level -= 1;
 	else if (Input::is_key_held(SDL_SCANCODE_P))
 		water_level += 1;
+#endif
 
 	Scene::update(delta_time);
 
-	Camera::get().position = player.position;
-
 	if (player.position.y > water_level)
 		Audio::set_global_filter(0, Audio::Filters::get_underwater_filter());
 	else
 		Audio::clear_global_filter(0);
 
+#if SE_SDL2
 	if (Input::is_key_pressed(SDL_SCANCODE_H))
 		get_current_renderer().take_screenshot("test.png");
+#endif
 }
 
 void Level::render(float delta_time)
 {
+	// Follow the player where it's drawn, between the last two ticks
+	Camera::get().position = player.get_render_position();
+	Camera::get().apply();
+
 	bg.render(delta_time);
 	Scene::render(delta_time);
 
@@ -0,0 +1,25 @@
+#include "Platform.hpp"
+
+#if !SE_SDL2
+
+#include "App.hpp"
+#include "Utils.hpp"
+
+// Platform code for builds without SDL, e.g. with the software renderer on build machines
+namespace Sputnik::App
+{
+    void platform_init() {}
+
+    void setup_exception_handler() {}
+
+    void handle_update() {}
+
+    // No display, the frame rate is not limited
+    float get_display_refresh_rate()
+    {
+        return 0;
+    }
+
+    void platform_quit() {}
+}
+#endif
@@ -9,5 +9,7 @@
 
 #include "renderers/SDL_GPU.hpp"
 #include "renderers/SDL2.hpp"
+#include "renderers/Software.hpp"
+#include "renderers/Recording.hpp"
 
 #endif // __RENDERERSALL_H__
\ No newline at end of file
@@ -12,7 +12,6 @@
 namespace Sputnik::App
 {
     SDL_Event event;
-    Uint64 now_time = 0, last_time;
 
     void setup_exception_handler()
     {
@@ -36,11 +35,12 @@ namespace Sputnik::App
             });
     }
 
-    void post_update(float& delta_time, float& fps)
+    float get_display_refresh_rate()
     {
-        now_time = SDL_GetPerformanceCounter();
-        delta_time = (float)(now_time - last_time) / SDL_GetPerformanceFrequency();
-        fps = 1 / delta_time;
+        SDL_DisplayMode mode;
+        if (SDL_GetCurrentDisplayMode(0, &mode) == 0 && mode.refresh_rate > 0)
+            return (float)mode.refresh_rate;
+        return 60;
     }
 
     void platform_quit()
@@ -34,13 +34,10 @@ namespace Sputnik::App
             });
     }
 
-    extern Uint64 last_time;
     extern SDL_Event event;
 
     void handle_update()
     {
-        last_time = SDL_GetPerformanceCounter();
-
         while (SDL_PollEvent(&event)) switch (event.type)
         {
             case SDL_QUIT:
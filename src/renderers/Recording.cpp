@@ -0,0 +1,614 @@
+#include "Recording.hpp"
+
+#include "Utils.hpp"
+
+namespace Sputnik
+{
+    namespace Renderer
+    {
+        void Recording_Renderer::Frame::clear()
+        {
+            commands.clear();
+            cameras.clear();
+            for (Read& read : reads)
+            {
+                if (read.done)
+                    read.done(false);
+            }
+            reads.clear();
+            textures.clear();
+            drawing = false;
+        }
+
+        Recording_Renderer::Recording_Renderer(std::unique_ptr<IRenderer> backend)
+            : backend(std::move(backend)), window(this->backend->get_window())
+        {
+            surface_size = this->backend->get_surface_size();
+            bg_color = this->backend->get_bg_color();
+            primitives_blend_mode = this->backend->get_primitives_blend_mode();
+
+            render_thread = std::thread(&Recording_Renderer::render_thread_loop, this);
+        }
+
+        Recording_Renderer::~Recording_Renderer()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                quit = true;
+            }
+            condition.notify_all();
+            render_thread.join();
+
+            // The textures of the last frames go before the renderer
+            recording.clear();
+            replaying.clear();
+        }
+
+        void Recording_Renderer::release_frames()
+        {
+            wait_idle();
+            recording.clear();
+            replaying.clear();
+            // Textures are kept alive again when they are recorded next
+            frame_index++;
+        }
+
+        void Recording_Renderer::render_thread_loop()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true)
+            {
+                condition.wait(lock, [this] { return busy || quit; });
+                if (!busy)
+                    return;
+
+                lock.unlock();
+                replay(replaying);
+                FrameCounters frame_counters = backend->get_counters();
+                lock.lock();
+
+                replayed_counters = frame_counters;
+                busy = false;
+                condition.notify_all();
+            }
+        }
+
+        void Recording_Renderer::wait_idle()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return !busy; });
+        }
+
+        void Recording_Renderer::replay(Frame& frame)
+        {
+            for (const Command& c : frame.commands)
+            {
+                switch (c.type)
+                {
+                    case CommandType::START_DRAWING:
+                        backend->start_drawing();
+                        break;
+                    case CommandType::ENABLE_CAMERA:
+                        backend->enable_camera(c.mode != 0);
+                        break;
+                    case CommandType::APPLY_CAMERA:
+                        backend->apply_camera(frame.cameras[c.index]);
+                        break;
+                    case CommandType::SET_BG_COLOR:
+                        backend->set_bg_color(c.color);
+                        break;
+                    case CommandType::SET_RENDER_TARGET:
+                        backend->set_render_target(*c.texture);
+                        break;
+                    case CommandType::RESET_RENDER_TARGET:
+                        backend->reset_render_target();
+                        break;
+                    case CommandType::SET_PRIMITIVES_BLEND_MODE:
+                        backend->set_primitives_blend_mode((BlendMode)c.mode);
+                        break;
+                    case CommandType::CLEAR:
+                        backend->clear(c.color);
+                        break;
+                    case CommandType::PIXEL:
+                        backend->pixel(c.pos, c.color);
+                        break;
+                    case CommandType::LINE:
+                        backend->line(c.pos, c.scale, c.color);
+                        break;
+                    case CommandType::RECTANGLE_OUTLINE:
+                        backend->rectangle_outline(c.rect, c.color);
+                        break;
+                    case CommandType::RECTANGLE_FILLED:
+                        backend->rectangle_filled(c.rect, c.color);
+                        break;
+                    case CommandType::CIRCLE_OUTLINE:
+                        backend->circle_outline(c.pos, c.degrees, c.color);
+                        break;
+                    case CommandType::CIRCLE_FILLED:
+                        backend->circle_filled(c.pos, c.degrees, c.color);
+                        break;
+                    case CommandType::DRAW_TEXTURE:
+                        backend->draw_texture(*c.texture, c.pos);
+                        break;
+                    case CommandType::DRAW_TEXTURE_SCALE:
+                        backend->draw_texture_scale(*c.texture, c.pos, c.scale);
+                        break;
+                    case CommandType::DRAW_TEXTURE_ROTATE:
+                        backend->draw_texture_rotate(*c.texture, c.pos, c.degrees);
+                        break;
+                    case CommandType::DRAW_TEXTURE_PART:
+                        backend->draw_texture_part(*c.texture, c.pos, c.rect);
+                        break;
+                    case CommandType::DRAW_TEXTURE_TRANSFORM:
+                        backend->draw_texture_transform(*c.texture, c.pos, c.scale, c.degrees);
+                        break;
+                    case CommandType::DRAW_TEXTURE_PART_TRANSFORM:
+                        backend->draw_texture_transform(*c.texture, c.pos, c.rect, c.scale, c.degrees);
+                        break;
+                    case CommandType::SET_TEXTURE_SCALE_MODE:
+                        backend->set_texture_scale_mode(*c.texture, (ScaleMode)c.mode);
+                        break;
+                    case CommandType::SET_TEXTURE_BLEND_MODE:
+                        backend->set_texture_blend_mode(*c.texture, (BlendMode)c.mode);
+                        break;
+                    case CommandType::SET_TEXTURE_TINT:
+                        backend->set_texture_tint(*c.texture, c.color);
+                        break;
+                    case CommandType::READ_PIXELS:
+                    {
+                        Read& read = frame.reads[c.index];
+                        backend->read_pixels(*read.buffer, std::move(read.done));
+                        read.done = nullptr;
+                        break;
+                    }
+                }
+            }
+
+            if (frame.drawing)
+                backend->end_drawing();
+        }
+
+        Recording_Renderer::Command& Recording_Renderer::record(CommandType type)
+        {
+            recording.commands.emplace_back();
+            Command& command = recording.commands.back();
+            command.type = type;
+            return command;
+        }
+
+        Recording_Renderer::Command& Recording_Renderer::record(CommandType type, const Texture& texture)
+        {
+            Recording_TextureData& data = get_data(texture);
+            if (data.recorded_frame != frame_index)
+            {
+                data.recorded_frame = frame_index;
+                recording.textures.push_back(data.texture);
+            }
+
+            Command& command = record(type);
+            command.texture = data.texture.get();
+            return command;
+        }
+
+        Recording_Renderer::Recording_TextureData& Recording_Renderer::get_data(const Texture& texture)
+        {
+            // The renderer data is only written by the main thread
+            return const_cast<Texture&>(texture).get_data<Recording_TextureData>();
+        }
+
+        std::unique_ptr<TextureData> Recording_Renderer::wrap(std::unique_ptr<TextureData> data)
+        {
+            auto result = Utils::make_unique<Recording_TextureData>();
+            result->texture = Utils::make_shared<Texture>();
+            result->texture->data = std::move(data);
+
+            // Called after the render thread went idle
+            result->scale_mode = backend->get_texture_scale_mode(*result->texture);
+            result->blend_mode = backend->get_texture_blend_mode(*result->texture);
+            result->tint = backend->get_texture_tint(*result->texture);
+            return result;
+        }
+
+        bool Recording_Renderer::is_feature_supported(Feature feature)
+        {
+            // Constant for a renderer, no need to wait
+            return backend->is_feature_supported(feature);
+        }
+
+        bool Recording_Renderer::is_blend_mode_supported(BlendMode mode)
+        {
+            return backend->is_blend_mode_supported(mode);
+        }
+
+        std::string Recording_Renderer::get_name()
+        {
+            return backend->get_name() + " (render thread)";
+        }
+
+        void Recording_Renderer::enable_camera(bool flag)
+        {
+            record(CommandType::ENABLE_CAMERA).mode = flag;
+            camera_enabled = flag;
+        }
+
+        bool Recording_Renderer::is_camera_enabled()
+        {
+            return camera_enabled;
+        }
+
+        void Recording_Renderer::apply_camera(const Camera& camera)
+        {
+            record(CommandType::APPLY_CAMERA).index = (int)recording.cameras.size();
+            recording.cameras.push_back(camera);
+        }
+
+        ScaleMode Recording_Renderer::get_default_scale_mode()
+        {
+            return backend->get_default_scale_mode();
+        }
+
+        void Recording_Renderer::set_default_scale_mode(ScaleMode mode)
+        {
+            // Only used when textures are created, which waits as well
+            wait_idle();
+            backend->set_default_scale_mode(mode);
+        }
+
+        IWindow& Recording_Renderer::get_window()
+        {
+            return *this;
+        }
+
+        Color Recording_Renderer::get_bg_color()
+        {
+            return bg_color;
+        }
+
+        void Recording_Renderer::set_bg_color(Color color)
+        {
+            bg_color = color;
+            record(CommandType::SET_BG_COLOR).color = color;
+        }
+
+        bool Recording_Renderer::set_render_target(Texture& texture)
+        {
+            if (!texture.is_loaded())
+            {
+                Log::error(SE_FUNCTION, ": texture is not loaded");
+                return false;
+            }
+
+            record(CommandType::SET_RENDER_TARGET, texture);
+            return true;
+        }
+
+        void Recording_Renderer::reset_render_target()
+        {
+            record(CommandType::RESET_RENDER_TARGET);
+        }
+
+        Vector2Int Recording_Renderer::get_surface_size()
+        {
+            return surface_size;
+        }
+
+        void Recording_Renderer::set_surface_size(int w, int h)
+        {
+            wait_idle();
+            backend->set_surface_size(w, h);
+            surface_size = backend->get_surface_size();
+        }
+
+        bool Recording_Renderer::use_screen_surface(bool flag)
+        {
+            wait_idle();
+            bool result = backend->use_screen_surface(flag);
+            surface_size = backend->get_surface_size();
+            return result;
+        }
+
+        bool Recording_Renderer::use_window(int id)
+        {
+            wait_idle();
+            bool result = backend->use_window(id);
+            surface_size = backend->get_surface_size();
+            return result;
+        }
+
+        BlendMode Recording_Renderer::get_primitives_blend_mode()
+        {
+            return primitives_blend_mode;
+        }
+
+        void Recording_Renderer::set_primitives_blend_mode(BlendMode mode)
+        {
+            primitives_blend_mode = mode;
+            record(CommandType::SET_PRIMITIVES_BLEND_MODE).mode = (char)mode;
+        }
+
+        void Recording_Renderer::clear(Color color)
+        {
+            record(CommandType::CLEAR).color = color;
+        }
+
+        void Recording_Renderer::pixel(Vector2 pos, Color color)
+        {
+            Command& command = record(CommandType::PIXEL);
+            command.pos = pos;
+            command.color = color;
+        }
+
+        void Recording_Renderer::line(Vector2 p1, Vector2 p2, Color color)
+        {
+            Command& command = record(CommandType::LINE);
+            command.pos = p1;
+            command.scale = p2;
+            command.color = color;
+        }
+
+        void Recording_Renderer::rectangle_outline(Rect rect, Color color)
+        {
+            Command& command = record(CommandType::RECTANGLE_OUTLINE);
+            command.rect = rect;
+            command.color = color;
+        }
+
+        void Recording_Renderer::rectangle_filled(Rect rect, Color color)
+        {
+            Command& command = record(CommandType::RECTANGLE_FILLED);
+            command.rect = rect;
+            command.color = color;
+        }
+
+        void Recording_Renderer::circle_outline(Vector2 centre, float radius, Color color)
+        {
+            Command& command = record(CommandType::CIRCLE_OUTLINE);
+            command.pos = centre;
+            command.degrees = radius;
+            command.color = color;
+        }
+
+        void Recording_Renderer::circle_filled(Vector2 centre, float radius, Color color)
+        {
+            Command& command = record(CommandType::CIRCLE_FILLED);
+            command.pos = centre;
+            command.degrees = radius;
+            command.color = color;
+        }
+
+        void Recording_Renderer::draw_texture(const Texture& texture, Vector2 pos)
+        {
+            record(CommandType::DRAW_TEXTURE, texture).pos = pos;
+        }
+
+        void Recording_Renderer::draw_texture_scale(const Texture& texture, Vector2 pos, Vector2 scale)
+        {
+            Command& command = record(CommandType::DRAW_TEXTURE_SCALE, texture);
+            command.pos = pos;
+            command.scale = scale;
+        }
+
+        void Recording_Renderer::draw_texture_rotate(const Texture& texture, Vector2 pos, float degrees)
+        {
+            Command& command = record(CommandType::DRAW_TEXTURE_ROTATE, texture);
+            command.pos = pos;
+            command.degrees = degrees;
+        }
+
+        void Recording_Renderer::draw_texture_part(const Texture& texture, Vector2 pos, Rect texture_rect)
+        {
+            Command& command = record(CommandType::DRAW_TEXTURE_PART, texture);
+            command.pos = pos;
+            command.rect = texture_rect;
+        }
+
+        void Recording_Renderer::draw_texture_transform(const Texture& texture, Vector2 pos,
+            Vector2 scale, float degrees)
+        {
+            Command& command = record(CommandType::DRAW_TEXTURE_TRANSFORM, texture);
+            command.pos = pos;
+            command.scale = scale;
+            command.degrees = degrees;
+        }
+
+        void Recording_Renderer::draw_texture_transform(const Texture& texture, Vector2 pos,
+            Rect texture_rect, Vector2 scale, float degrees)
+        {
+            Command& command = record(CommandType::DRAW_TEXTURE_PART_TRANSFORM, texture);
+            command.pos = pos;
+            command.rect = texture_rect;
+            command.scale = scale;
+            command.degrees = degrees;
+        }
+
+        FrameCounters Recording_Renderer::get_counters()
+        {
+            FrameCounters result;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                result = replayed_counters;
+            }
+
+            // The texture totals are current
+            FrameCounters totals = IRenderer::get_counters();
+            result.texture_memory = totals.texture_memory;
+            result.render_targets = totals.render_targets;
+            return result;
+        }
+
+        void Recording_Renderer::read_pixels(PixelBuffer& buffer, std::function<void(bool)> done)
+        {
+            record(CommandType::READ_PIXELS).index = (int)recording.reads.size();
+            recording.reads.push_back({ &buffer, std::move(done) });
+        }
+
+        void Recording_Renderer::start_drawing()
+        {
+            record(CommandType::START_DRAWING);
+            recording.drawing = true;
+        }
+
+        void Recording_Renderer::end_drawing()
+        {
+            wait_idle();
+
+            // Textures of the replayed frame are released here, on the main thread
+            std::swap(recording, replaying);
+            recording.clear();
+            frame_index++;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy = true;
+            }
+            condition.notify_all();
+        }
+
+        /* Window methods */
+
+        std::string Recording_Renderer::get_window_name()
+        {
+            wait_idle();
+            return window.get_window_name();
+        }
+
+        void Recording_Renderer::set_window_name(const char* name)
+        {
+            wait_idle();
+            window.set_window_name(name);
+        }
+
+        Vector2Int Recording_Renderer::get_window_resolution()
+        {
+            wait_idle();
+            return window.get_window_resolution();
+        }
+
+        void Recording_Renderer::set_window_resolution(int w, int h)
+        {
+            wait_idle();
+            window.set_window_resolution(w, h);
+        }
+
+        void Recording_Renderer::handle_resolution_update(int w, int h)
+        {
+            wait_idle();
+            window.handle_resolution_update(w, h);
+            surface_size = backend->get_surface_size();
+        }
+
+        Vector2Int Recording_Renderer::get_window_position()
+        {
+            wait_idle();
+            return window.get_window_position();
+        }
+
+        void Recording_Renderer::set_window_position(int x, int y)
+        {
+            wait_idle();
+            window.set_window_position(x, y);
+        }
+
+        void Recording_Renderer::center_window()
+        {
+            wait_idle();
+            window.center_window();
+        }
+
+        void Recording_Renderer::set_resizable(bool enable)
+        {
+            wait_idle();
+            window.set_resizable(enable);
+        }
+
+        void Recording_Renderer::set_fullscreen(bool flag)
+        {
+            wait_idle();
+            window.set_fullscreen(flag);
+        }
+
+        bool Recording_Renderer::get_fullscreen()
+        {
+            wait_idle();
+            return window.get_fullscreen();
+        }
+
+        /* Texture methods */
+
+        std::unique_ptr<TextureData> Recording_Renderer::create_texture(int w, int h, bool texture_target)
+        {
+            wait_idle();
+            return wrap(backend->create_texture(w, h, texture_target));
+        }
+
+        std::unique_ptr<TextureData> Recording_Renderer::create_texture(const char* filename)
+        {
+            wait_idle();
+            return wrap(backend->create_texture(filename));
+        }
+
+        std::unique_ptr<TextureData> Recording_Renderer::create_texture(unsigned char* buffer, int size)
+        {
+            wait_idle();
+            return wrap(backend->create_texture(buffer, size));
+        }
+
+#if SE_SDL2
+        std::unique_ptr<TextureData> Recording_Renderer::create_texture(SDL_Surface* surface)
+        {
+            wait_idle();
+            return wrap(backend->create_texture(surface));
+        }
+#endif
+
+        // The size of a texture never changes, it's safe to read during the replay
+
+        int Recording_Renderer::get_texture_width(const Texture& texture)
+        {
+            return backend->get_texture_width(*get_data(texture).texture);
+        }
+
+        int Recording_Renderer::get_texture_height(const Texture& texture)
+        {
+            return backend->get_texture_height(*get_data(texture).texture);
+        }
+
+        Vector2Int Recording_Renderer::get_texture_size(const Texture& texture)
+        {
+            return backend->get_texture_size(*get_data(texture).texture);
+        }
+
+        void Recording_Renderer::set_texture_scale_mode(Texture& texture, ScaleMode mode)
+        {
+            record(CommandType::SET_TEXTURE_SCALE_MODE, texture).mode = (char)mode;
+            get_data(texture).scale_mode = mode;
+        }
+
+        ScaleMode Recording_Renderer::get_texture_scale_mode(const Texture& texture)
+        {
+            return get_data(texture).scale_mode;
+        }
+
+        void Recording_Renderer::set_texture_blend_mode(Texture& texture, BlendMode mode)
+        {
+            record(CommandType::SET_TEXTURE_BLEND_MODE, texture).mode = (char)mode;
+            get_data(texture).blend_mode = mode;
+        }
+
+        BlendMode Recording_Renderer::get_texture_blend_mode(const Texture& texture)
+        {
+            return get_data(texture).blend_mode;
+        }
+
+        void Recording_Renderer::set_texture_tint(Texture& texture, Color color)
+        {
+            record(CommandType::SET_TEXTURE_TINT, texture).color = color;
+            get_data(texture).tint = color;
+        }
+
+        Color Recording_Renderer::get_texture_tint(const Texture& texture)
+        {
+            return get_data(texture).tint;
+        }
+    }
+}
@@ -0,0 +1,261 @@
+#ifndef __RECORDING_H__
+#define __RECORDING_H__
+
+#include "Renderer.hpp"
+#include "Platform.hpp"
+#include "Scene.hpp"
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Sputnik
+{
+    namespace Renderer
+    {
+        /*
+            Front-end that records the rendering calls of a frame into a command
+            buffer and replays them against the real renderer on a render thread.
+            The next frame is simulated and recorded while the previous one is
+            replayed and presented, at most one frame is in flight.
+
+            Calls that have to return a value from the renderer (texture creation,
+            surface and window changes) wait until the render thread is idle.
+            The renderer must support Feature::RENDER_THREAD, which only the
+            software renderer does: SDL2 and SDL_gpu keep drawing on the main
+            thread, so their vsync and driver latency still stall the game loop.
+        */
+        class Recording_Renderer final : public IRenderer, public IWindow
+        {
+        public:
+            // Texture of the real renderer, shared with the frames that draw it,
+            // so it lives until they are replayed
+            class Recording_TextureData : public TextureData
+            {
+            public:
+                std::shared_ptr<Texture> texture;
+                // Last frame that keeps the texture alive
+                unsigned long recorded_frame = (unsigned long)-1;
+                // State last recorded, so the getters don't wait for the replay
+                ScaleMode scale_mode = ScaleMode::NEAREST;
+                BlendMode blend_mode = BlendMode::NORMAL;
+                Color tint = Colors::WHITE;
+            };
+
+            explicit Recording_Renderer(std::unique_ptr<IRenderer> backend);
+            ~Recording_Renderer();
+
+            // The renderer the commands are replayed against
+            IRenderer& get_backend() { return *backend; }
+            // Wait for the render thread and drop the commands not yet replayed,
+            // so the textures the frames keep alive are freed
+            void release_frames();
+
+			bool is_feature_supported(Feature feature) override;
+			bool is_blend_mode_supported(BlendMode mode) override;
+
+			std::string get_name() override;
+
+			void enable_camera(bool flag) override;
+			bool is_camera_enabled() override;
+			void apply_camera(const Camera& camera) override;
+
+			ScaleMode get_default_scale_mode() override;
+			void set_default_scale_mode(ScaleMode mode) override;
+
+            IWindow& get_window() override;
+
+			/* Rendering */
+
+			Color get_bg_color() override;
+			void set_bg_color(Color color) override;
+
+			// The result of the renderer is only known at replay,
+			// so it returns false only for textures that aren't loaded
+			bool set_render_target(Texture& texture) override;
+			void reset_render_target() override;
+
+			Vector2Int get_surface_size() override;
+			void set_surface_size(int w, int h) override;
+			bool use_screen_surface(bool flag) override;
+            bool use_window(int id) override;
+
+			BlendMode get_primitives_blend_mode() override;
+			void set_primitives_blend_mode(BlendMode mode) override;
+
+			void clear(Color color = Colors::NONE) override;
+			void pixel(Vector2 pos, Color color) override;
+			void line(Vector2 p1, Vector2 p2, Color color) override;
+			void rectangle_outline(Rect rect, Color color) override;
+			void rectangle_filled(Rect rect, Color color) override;
+			void circle_outline(Vector2 centre, float radius, Color color) override;
+			void circle_filled(Vector2 centre, float radius, Color color) override;
+
+			void draw_texture(const Texture& texture, Vector2 pos) override;
+			void draw_texture_scale(const Texture& texture, Vector2 pos, Vector2 scale) override;
+			void draw_texture_rotate(const Texture& texture, Vector2 pos, float degrees) override;
+			void draw_texture_part(const Texture& texture, Vector2 pos, Rect texture_rect) override;
+			void draw_texture_transform(const Texture& texture, Vector2 pos,
+				Vector2 scale, float degrees) override;
+			void draw_texture_transform(const Texture& texture, Vector2 pos,
+				Rect texture_rect, Vector2 scale, float degrees) override;
+
+			// The pixels are read when the frame is replayed,
+			// done is called on the render thread
+			void read_pixels(PixelBuffer& buffer, std::function<void(bool)> done) override;
+			// Counters of the backend for the last replayed frame
+			FrameCounters get_counters() override;
+
+			void start_drawing() override;
+			// Hands the frame to the render thread
+			void end_drawing() override;
+
+			/* Window methods wait for the render thread */
+
+			std::string get_window_name() override;
+			void set_window_name(const char* name) override;
+
+			Vector2Int get_window_resolution() override;
+            void set_window_resolution(int w, int h) override;
+            void handle_resolution_update(int w, int h) override;
+
+			Vector2Int get_window_position() override;
+			void set_window_position(int x, int y) override;
+			void center_window() override;
+
+			void set_resizable(bool enable) override;
+
+			void set_fullscreen(bool flag) override;
+			bool get_fullscreen() override;
+
+        private:
+            enum class CommandType : char
+            {
+                START_DRAWING,
+                ENABLE_CAMERA,
+                APPLY_CAMERA,
+                SET_BG_COLOR,
+                SET_RENDER_TARGET,
+                RESET_RENDER_TARGET,
+                SET_PRIMITIVES_BLEND_MODE,
+                CLEAR,
+                PIXEL,
+                LINE,
+                RECTANGLE_OUTLINE,
+                RECTANGLE_FILLED,
+                CIRCLE_OUTLINE,
+                CIRCLE_FILLED,
+                DRAW_TEXTURE,
+                DRAW_TEXTURE_SCALE,
+                DRAW_TEXTURE_ROTATE,
+                DRAW_TEXTURE_PART,
+                DRAW_TEXTURE_TRANSFORM,
+                DRAW_TEXTURE_PART_TRANSFORM,
+                SET_TEXTURE_SCALE_MODE,
+                SET_TEXTURE_BLEND_MODE,
+                SET_TEXTURE_TINT,
+                READ_PIXELS,
+            };
+
+            // Fields are reused by the commands, see replay()
+            struct Command
+            {
+                CommandType type;
+                // Scale mode, blend mode or flag
+                char mode = 0;
+                Color color = {};
+                // Angle or radius
+                float degrees = 0;
+                Vector2 pos = {};
+                // Scale or the second point of a line
+                Vector2 scale = {};
+                Rect rect = {};
+                // Kept alive by Frame::textures, index in Frame::reads for readbacks
+                Texture* texture = nullptr;
+                int index = 0;
+            };
+
+            struct Read
+            {
+                PixelBuffer* buffer;
+                // Reset once called
+                std::function<void(bool)> done;
+            };
+
+            struct Frame
+            {
+                std::vector<Command> commands;
+                std::vector<Camera> cameras;
+                std::vector<Read> reads;
+                std::vector<std::shared_ptr<Texture>> textures;
+                bool drawing = false;
+
+                // Reads that weren't replayed fail
+                void clear();
+            };
+
+            std::unique_ptr<IRenderer> backend;
+            IWindow& window;
+
+            // Written by the main thread
+            Frame recording;
+            // Last enable_camera() call recorded
+            bool camera_enabled = true;
+            // Read by the render thread while it's busy
+            Frame replaying;
+            unsigned long frame_index = 0;
+
+            std::thread render_thread;
+            std::mutex mutex;
+            std::condition_variable condition;
+            bool busy = false;
+            bool quit = false;
+
+            // Getters return these without waiting. The surface size only
+            // changes while the render thread is idle, because apply_camera()
+            // reads it during the replay.
+            Vector2Int surface_size;
+            // Copied from the backend after every replay
+            FrameCounters replayed_counters;
+            // Values last recorded
+            Color bg_color;
+            BlendMode primitives_blend_mode;
+
+            void render_thread_loop();
+            // Block until the last submitted frame is replayed
+            void wait_idle();
+            void replay(Frame& frame);
+
+            Command& record(CommandType type);
+            Command& record(CommandType type, const Texture& texture);
+            Recording_TextureData& get_data(const Texture& texture);
+            std::unique_ptr<TextureData> wrap(std::unique_ptr<TextureData> data);
+
+			/* Texture methods */
+
+            std::unique_ptr<TextureData> create_texture(int w, int h, bool texture_target) override;
+            std::unique_ptr<TextureData> create_texture(const char* filename) override;
+            std::unique_ptr<TextureData> create_texture(unsigned char* buffer, int size) override;
+#if SE_SDL2
+			std::unique_ptr<TextureData> create_texture(SDL_Surface* surface) override;
+#endif
+
+			int get_texture_width(const Texture& texture) override;
+            int get_texture_height(const Texture& texture) override;
+			Vector2Int get_texture_size(const Texture& texture) override;
+
+			void set_texture_scale_mode(Texture& texture, ScaleMode mode) override;
+			ScaleMode get_texture_scale_mode(const Texture& texture) override;
+
+			void set_texture_blend_mode(Texture& texture, BlendMode mode) override;
+			BlendMode get_texture_blend_mode(const Texture& texture) override;
+
+			void set_texture_tint(Texture& texture, Color color) override;
+            Color get_texture_tint(const Texture& texture) override;
+        };
+    }
+}
+
+#endif // __RECORDING_H__
@@ -9,19 +9,39 @@
 
 #include "SDL_image.h"
 
+#include <cmath>
+#include <utility>
+
 namespace Sputnik
 {
     namespace Renderer
     {
-        SDL2_Renderer::SDL2_TextureData::SDL2_TextureData(SDL_Texture* texture, SDL_ScaleMode mode)
-            : texture(texture)
-        {
-            SDL_QueryTexture(texture, nullptr, nullptr, &size.x, &size.y);
+        SDL2_Renderer::SDL2_TextureData::SDL2_TextureData(SDL2_Renderer* owner,
+            SDL_Texture* texture, SDL_ScaleMode mode)
+            : owner(owner), texture(texture), scale_mode(mode), blend_mode(SDL_BLENDMODE_NONE)
+        {
+            owner->textures.insert(this);
+            int access = SDL_TEXTUREACCESS_STATIC;
+            if (SDL_QueryTexture(texture, nullptr, &access, &size.x, &size.y) == 0)
+                set_memory_usage(size, access == SDL_TEXTUREACCESS_TARGET);
             SDL_SetTextureScaleMode(texture, mode);
+            SDL_GetTextureBlendMode(texture, &blend_mode);
         }
 
         SDL2_Renderer::SDL2_TextureData::~SDL2_TextureData()
         {
+            // SDL already freed it with the renderer
+            if (!owner)
+                return;
+
+            owner->textures.erase(this);
+            // Temporary textures can be freed right after being drawn
+            if (owner->batch_texture == texture)
+                owner->flush_batch();
+            // SDL goes back to the default target, a new texture
+            // at the same address must not match the shadow
+            if (owner->render_target == texture)
+                owner->render_target = nullptr;
             SDL_DestroyTexture(texture);
         }
 
@@ -75,11 +95,14 @@ namespace Sputnik
         SDL2_Renderer::SDL2_Renderer(SDL_Window* win, SDL_Renderer* render)
             : win(win), render(render), camera_enabled(true), screen_surface(false)
         {
+            // Matches the initial shadow state
             SDL_SetRenderDrawBlendMode(render, SDL_BLENDMODE_BLEND);
+            SDL_SetRenderDrawColor(render, draw_color.r, draw_color.g, draw_color.b, draw_color.a);
 
             SDL_RendererInfo info;
             SDL_GetRendererInfo(render, &info);
-            use_software_vsync = !strcmp(info.name, "software");
+            // The software fallback is created without vsync, App paces the frames then
+            vsync = (info.flags & SDL_RENDERER_PRESENTVSYNC) != 0;
 
             if (SDL_RenderTargetSupported(render))
             {
@@ -102,6 +125,15 @@ namespace Sputnik
 
         SDL2_Renderer::~SDL2_Renderer()
         {
+            // Textures that outlive the renderer (globals, statics...)
+            // are destroyed by SDL_DestroyRenderer()
+            for (SDL2_TextureData* data : textures)
+            {
+                data->owner = nullptr;
+                data->texture = nullptr;
+            }
+            textures.clear();
+
             IMG_Quit();
             SDL_DestroyTexture(surface);
             SDL_DestroyRenderer(render);
@@ -120,6 +152,11 @@ namespace Sputnik
                 case Feature::SCREENSHOT:
                     return true;
 
+                case Feature::VSYNC:
+                    return vsync;
+
+                // SDL_Renderer must stay on the thread that created the window
+                case Feature::RENDER_THREAD:
                 // I want to clearly show that, unfortunately,
                 // SDL2 does not support custom shaders.
                 case Feature::SHADERS:
@@ -130,12 +167,9 @@ namespace Sputnik
 
         bool SDL2_Renderer::is_blend_mode_supported(BlendMode mode)
         {
-            SDL_BlendMode default_mode;
-            SDL_GetRenderDrawBlendMode(render, &default_mode);
-
             if (!SDL_SetRenderDrawBlendMode(render, engine_to_sdl_blend(mode)))
             {
-                SDL_SetRenderDrawBlendMode(render, default_mode);
+                SDL_SetRenderDrawBlendMode(render, draw_blend_mode);
                 return true;
             }
 
@@ -155,13 +189,14 @@ namespace Sputnik
             camera_zoom_or_angle = flag && ((camera_zoom != 1) || (camera_angle != 0));
         }
 
-        void SDL2_Renderer::apply_camera(const Camera& camera)
+        bool SDL2_Renderer::is_camera_enabled()
         {
-            float w = get_surface_size().x / 2.0f;
-            float h = get_surface_size().y / 2.0f;
+            return camera_enabled;
+        }
 
-            camera_pos.x = camera.get_left() - w + w / camera.zoom;
-            camera_pos.y = camera.get_up() - h + h / camera.zoom;
+        void SDL2_Renderer::apply_camera(const Camera& camera)
+        {
+            camera_transform = camera.get_transform(get_surface_size().convert_to<float>());
             camera_angle = camera.angle;
             camera_zoom = camera.zoom;
 
@@ -195,12 +230,14 @@ namespace Sputnik
 
         bool SDL2_Renderer::set_render_target(Texture& texture)
         {
-            return !SDL_SetRenderTarget(render, get_texture(texture));
+            flush_batch();
+            return set_target(get_texture(texture));
         }
 
         void SDL2_Renderer::reset_render_target()
         {
-            SDL_SetRenderTarget(render, screen_surface ? nullptr : surface);
+            flush_batch();
+            set_target(screen_surface ? nullptr : surface);
         }
 
         Vector2Int SDL2_Renderer::get_surface_size()
@@ -210,7 +247,8 @@ namespace Sputnik
 
         void SDL2_Renderer::set_surface_size(int w, int h)
         {
-            SDL_SetRenderTarget(render, nullptr);
+            flush_batch();
+            set_target(nullptr);
             SDL_RenderSetLogicalSize(render, w, h);
 
             if (surface)
@@ -220,7 +258,7 @@ namespace Sputnik
                     SDL_TEXTUREACCESS_TARGET, w, h);
                 surface_size = { w, h };
                 if (!screen_surface)
-                    SDL_SetRenderTarget(render, surface);
+                    set_target(surface);
             }
         }
 
@@ -243,76 +281,131 @@ namespace Sputnik
 
         void SDL2_Renderer::set_primitives_blend_mode(BlendMode mode)
         {
-            SDL_SetRenderDrawBlendMode(render, primitives_blend_mode = engine_to_sdl_blend(mode));
+            // Batched primitives take the blend mode when they are flushed
+            flush_batch();
+            set_draw_blend_mode(primitives_blend_mode = engine_to_sdl_blend(mode));
         }
 
         BlendMode SDL2_Renderer::get_primitives_blend_mode()
         {
-            SDL_BlendMode mode;
-            SDL_GetRenderDrawBlendMode(render, &mode);
-            return sdl_to_engine_blend(mode);
+            return sdl_to_engine_blend(primitives_blend_mode);
         }
 
         // TODO: only clear the surface area if using screen surface
         void SDL2_Renderer::clear(Color color)
         {
-            SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
+            flush_batch();
+            set_draw_color(color);
             SDL_RenderClear(render);
+
+            Vector2Int size = get_target_size();
+            counters.draw_calls++;
+            counters.pixels_filled += (unsigned long long)size.x * size.y;
         }
 
-        // TODO: make primitives affected by camera
-        // for that: update SDL2 to the latest update and use SDL_RenderGeometry
+        // Primitives are drawn in playfield coordinates like the textures
+
         void SDL2_Renderer::pixel(Vector2 pos, Color color)
         {
-            SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
-            SDL_RenderDrawPointF(render, pos.x, pos.y);
+            rectangle_filled({ pos.x, pos.y, 1, 1 }, color);
         }
 
         void SDL2_Renderer::line(Vector2 p1, Vector2 p2, Color color)
         {
-            SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
-            SDL_RenderDrawLineF(render, p1.x, p1.y, p2.x, p2.y);
+            begin_primitives();
+            counters.primitives++;
+            // Through the pixel centres, like SDL_RenderDrawLine()
+            add_line(camera_point(p1) + Vector2{ 0.5f, 0.5f },
+                camera_point(p2) + Vector2{ 0.5f, 0.5f }, color);
         }
 
         void SDL2_Renderer::rectangle_outline(Rect rect, Color color)
         {
-            SDL_Rect rect2 = rect;
-            SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
-            SDL_RenderDrawRect(render, &rect2);
+            begin_primitives();
+            counters.primitives++;
+            Vector2 corners[4] = {
+                camera_point({ rect.x, rect.y }), camera_point({ rect.x + rect.w, rect.y }),
+                camera_point({ rect.x + rect.w, rect.y + rect.h }), camera_point({ rect.x, rect.y + rect.h }),
+            };
+
+            // Pixel centres of the border, the lines stay inside the rectangle
+            Vector2 centre = (corners[0] + corners[2]) / 2;
+            for (Vector2& c : corners)
+            {
+                Vector2 inward = centre - c;
+                float length = inward.length();
+                if (length > 0)
+                    c += inward / length * 0.70710678f;
+            }
+
+            for (int i = 0; i < 4; i++)
+                add_line(corners[i], corners[(i + 1) % 4], color);
         }
 
         void SDL2_Renderer::rectangle_filled(Rect rect, Color color)
         {
-            SDL_Rect rect2 = rect;
-            SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
-            SDL_RenderFillRect(render, &rect2);
+            begin_primitives();
+            counters.primitives++;
+            Vector2 corners[4] = {
+                camera_point({ rect.x, rect.y }), camera_point({ rect.x + rect.w, rect.y }),
+                camera_point({ rect.x + rect.w, rect.y + rect.h }), camera_point({ rect.x, rect.y + rect.h }),
+            };
+            add_quad(corners, color);
         }
 
         void SDL2_Renderer::circle_outline(Vector2 centre, float radius, Color color)
         {
-            SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
-            // TODO
+            begin_primitives();
+            Vector2 c = camera_point(centre) + Vector2{ 0.5f, 0.5f };
+            float r = radius * camera_scale();
+            counters.primitives++;
+            counters.pixels_filled += (unsigned long long)(2 * M_PI * r);
+            const std::vector<Vector2>& points = get_circle(r);
+
+            // A ring one pixel wide
+            int first = (int)batch_vertices.size();
+            int count = (int)points.size();
+            for (const Vector2& p : points)
+            {
+                add_vertex(c + p * (r + 0.5f), color);
+                add_vertex(c + p * std::max(r - 0.5f, 0.f), color);
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                int a = first + i * 2, b = first + ((i + 1) % count) * 2;
+                const int indices[6] = { a, a + 1, b, b, a + 1, b + 1 };
+                batch_indices.insert(batch_indices.end(), indices, indices + 6);
+            }
         }
 
         void SDL2_Renderer::circle_filled(Vector2 centre, float radius, Color color)
         {
-            SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
-            // TODO
+            begin_primitives();
+            Vector2 c = camera_point(centre) + Vector2{ 0.5f, 0.5f };
+            float r = radius * camera_scale();
+            counters.primitives++;
+            counters.pixels_filled += (unsigned long long)(M_PI * r * r);
+            const std::vector<Vector2>& points = get_circle(r);
+
+            // Triangle fan around the centre
+            int first = (int)batch_vertices.size();
+            int count = (int)points.size();
+            add_vertex(c, color);
+            for (const Vector2& p : points)
+                add_vertex(c + p * r, color);
+
+            for (int i = 0; i < count; i++)
+            {
+                const int indices[3] = { first, first + 1 + i, first + 1 + (i + 1) % count };
+                batch_indices.insert(batch_indices.end(), indices, indices + 3);
+            }
         }
 
         void SDL2_Renderer::draw_texture(const Texture& texture, Vector2 pos)
         {
-            Vector2 pos_int = pos,
-                size = get_texture_size(texture).convert_to<float>();
-            float degrees = 0;
-
-            camera_vector(pos_int, size, degrees);
-
-            SDL_FRect rect = { pos_int.x, pos_int.y, size.x, size.y };
-            if (!camera_zoom_or_angle)
-                SDL_RenderCopyF(render, get_texture(texture), nullptr, &rect);
-            else
-                SDL_RenderCopyExF(render, get_texture(texture), nullptr, &rect, degrees, nullptr, SDL_FLIP_NONE);
+            batch_quad(texture, nullptr, pos, get_texture_size(texture).convert_to<float>(),
+                0, SDL_FLIP_NONE);
         }
 
         SDL_RendererFlip get_flip(Vector2& scale)
@@ -336,56 +429,29 @@ namespace Sputnik
         void SDL2_Renderer::draw_texture_scale(const Texture& texture, Vector2 pos, Vector2 scale)
         {
             SDL_RendererFlip flip = get_flip(scale);
-            Vector2 pos_int = pos,
-                size = get_texture_size(texture).convert_to<float>() * scale;
-            float degrees = 0;
-
-            camera_vector(pos_int, size, degrees);
-
-            SDL_FRect rect = {pos_int.x, pos_int.y, size.x, size.y};
-            SDL_RenderCopyExF(render, get_texture(texture), nullptr, &rect, degrees, nullptr, flip);
+            batch_quad(texture, nullptr, pos, get_texture_size(texture).convert_to<float>() * scale,
+                0, flip);
         }
 
         void SDL2_Renderer::draw_texture_rotate(const Texture& texture, Vector2 pos, float degrees)
         {
-            Vector2 pos_int = pos,
-                size = get_texture_size(texture).convert_to<float>();
-
-            camera_vector(pos_int, size, degrees);
-
-            SDL_FRect rect = { pos_int.x, pos_int.y, size.x, size.y };
-            SDL_RenderCopyExF(render, get_texture(texture), nullptr, &rect, degrees, nullptr, SDL_FLIP_NONE);
+            batch_quad(texture, nullptr, pos, get_texture_size(texture).convert_to<float>(),
+                degrees, SDL_FLIP_NONE);
         }
 
         void SDL2_Renderer::draw_texture_part(const Texture& texture, Vector2 pos, Rect texture_rect)
         {
             SDL_Rect tex_rect = texture_rect;
-            Vector2 pos_int = pos,
-                size = { (float)tex_rect.w, (float)tex_rect.h };
-            float degrees = 0;
-
-            camera_vector(pos_int, size, degrees);
-
-            SDL_FRect rect = { pos_int.x, pos_int.y, size.x, size.y };
-            if (!camera_zoom_or_angle)
-                SDL_RenderCopyF(render, get_texture(texture), &tex_rect, &rect);
-            else
-                SDL_RenderCopyExF(render, get_texture(texture), &tex_rect, &rect,
-                    degrees, nullptr, SDL_FLIP_NONE);
+            batch_quad(texture, &tex_rect, pos, { (float)tex_rect.w, (float)tex_rect.h },
+                0, SDL_FLIP_NONE);
         }
 
         void SDL2_Renderer::draw_texture_transform(const Texture& texture, Vector2 pos,
                         Vector2 scale, float degrees)
         {
             SDL_RendererFlip flip = get_flip(scale);
-            Vector2 pos_int = pos,
-                size = get_texture_size(texture).convert_to<float>() * scale;
-
-            camera_vector(pos_int, size, degrees);
-
-            SDL_FRect rect = { pos_int.x, pos_int.y, size.x, size.y };
-            SDL_RenderCopyExF(render, get_texture(texture),
-                nullptr, &rect, degrees, nullptr, flip);
+            batch_quad(texture, nullptr, pos, get_texture_size(texture).convert_to<float>() * scale,
+                degrees, flip);
         }
 
         void SDL2_Renderer::draw_texture_transform(const Texture& texture, Vector2 pos,
@@ -393,47 +459,162 @@ namespace Sputnik
         {
             SDL_RendererFlip flip = get_flip(scale);
             SDL_Rect tex_rect = texture_rect;
-            Vector2 pos_int = pos,
-                size = Vector2{ (float)tex_rect.w, (float)tex_rect.h } * scale;
+            batch_quad(texture, &tex_rect, pos, Vector2{ (float)tex_rect.w, (float)tex_rect.h } * scale,
+                degrees, flip);
+        }
 
-            camera_vector(pos_int, size, degrees);
+        void SDL2_Renderer::read_pixels(PixelBuffer& buffer, std::function<void(bool)> done)
+        {
+            flush_batch();
+
+            buffer.size = get_target_size();
+            buffer.pixels.resize((size_t)buffer.size.x * buffer.size.y);
 
-            SDL_FRect rect = { pos_int.x, pos_int.y, size.x, size.y };
-            SDL_RenderCopyExF(render, get_texture(texture),
-                &tex_rect, &rect, degrees, nullptr, flip);
+            bool success = SDL_RenderReadPixels(render, nullptr, SDL_PIXELFORMAT_RGBA32,
+                buffer.pixels.data(), buffer.size.x * 4) == 0;
+            if (!success)
+                Log::error(SE_FUNCTION, ": Can't read pixels: ", SDL_GetError());
+            done(success);
         }
 
-        bool SDL2_Renderer::take_screenshot(const char* filename)
+        void SDL2_Renderer::batch_quad(const Texture& texture, const SDL_Rect* src,
+            Vector2 pos, Vector2 size, float degrees, SDL_RendererFlip flip)
         {
-            int width, height;
-            SDL_Surface* screenshot;
+            const SDL2_TextureData& data = texture.get_const_data<SDL2_TextureData>();
+            // A null texture would be drawn as a primitive
+            if (!data.texture)
+                return;
 
-            SDL_GetRendererOutputSize(render, &width, &height);
-            screenshot = SDL_CreateRGBSurface(0, width, height, 32, 0, 0, 0, 0);
-            if (!surface)
+            if (data.texture != batch_texture)
             {
-                Log::error(SE_FUNCTION, ": Can't create a surface for the screenshot: ", SDL_GetError());
-                return false;
+                flush_batch();
+                batch_texture = data.texture;
+                counters.texture_binds++;
             }
 
-            if (SDL_RenderReadPixels(render, nullptr, screenshot->format->format,
-                screenshot->pixels, screenshot->pitch) < 0)
+            // pos becomes the top left corner of the unrotated quad
+            camera_vector(pos, size, degrees);
+            counters.textured_quads++;
+            counters.pixels_filled += (unsigned long long)std::abs(size.x * size.y);
+
+            float u0 = 0, v0 = 0, u1 = 1, v1 = 1;
+            if (src)
             {
-                Log::error(SE_FUNCTION, ": Can't read pixels for screenshot: ", SDL_GetError());
-                SDL_FreeSurface(screenshot);
-                return false;
+                u0 = (float)src->x / data.size.x;
+                v0 = (float)src->y / data.size.y;
+                u1 = (float)(src->x + src->w) / data.size.x;
+                v1 = (float)(src->y + src->h) / data.size.y;
+            }
+            if (flip & SDL_FLIP_HORIZONTAL)
+                std::swap(u0, u1);
+            if (flip & SDL_FLIP_VERTICAL)
+                std::swap(v0, v1);
+
+            // Corners relative to the centre, clockwise from the top left one
+            Vector2 half = size / 2;
+            Vector2 centre = pos + half;
+            Vector2 corners[4] = {
+                { -half.x, -half.y }, { half.x, -half.y },
+                { half.x, half.y }, { -half.x, half.y },
+            };
+
+            if (degrees != 0)
+            {
+                float rad = degrees * M_PI / 180.0;
+                float sin_value = std::sin(rad), cos_value = std::cos(rad);
+                for (Vector2& c : corners)
+                    c = { c.x * cos_value - c.y * sin_value, c.x * sin_value + c.y * cos_value };
             }
 
-            if (IMG_SavePNG(screenshot, filename) < 0)
+            const float u[4] = { u0, u1, u1, u0 };
+            const float v[4] = { v0, v0, v1, v1 };
+            SDL_Color color = data.tint;
+
+            int first = (int)batch_vertices.size();
+            for (int i = 0; i < 4; i++)
+                batch_vertices.push_back({ { centre.x + corners[i].x, centre.y + corners[i].y },
+                    color, { u[i], v[i] } });
+
+            static const int QUAD_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int i : QUAD_INDICES)
+                batch_indices.push_back(first + i);
+        }
+
+        void SDL2_Renderer::flush_batch()
+        {
+            if (!batch_indices.empty())
             {
-                Log::error(SE_FUNCTION, ": Can't save screenshot to file '",
-                    filename, "': ", IMG_GetError());
-                SDL_FreeSurface(screenshot);
-                return false;
+                SDL_RenderGeometry(render, batch_texture, batch_vertices.data(), (int)batch_vertices.size(),
+                    batch_indices.data(), (int)batch_indices.size());
+                counters.draw_calls++;
             }
 
-            SDL_FreeSurface(screenshot);
-            return true;
+            batch_vertices.clear();
+            batch_indices.clear();
+            batch_texture = nullptr;
+        }
+
+        void SDL2_Renderer::begin_primitives()
+        {
+            if (batch_texture)
+                flush_batch();
+        }
+
+        void SDL2_Renderer::add_vertex(Vector2 pos, SDL_Color color)
+        {
+            batch_vertices.push_back({ { pos.x, pos.y }, color, { 0, 0 } });
+        }
+
+        void SDL2_Renderer::add_quad(const Vector2 corners[4], SDL_Color color)
+        {
+            int first = (int)batch_vertices.size();
+            for (int i = 0; i < 4; i++)
+                add_vertex(corners[i], color);
+
+            static const int QUAD_INDICES[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int i : QUAD_INDICES)
+                batch_indices.push_back(first + i);
+
+            // Half the cross product of the diagonals
+            Vector2 d1 = corners[2] - corners[0], d2 = corners[3] - corners[1];
+            counters.pixels_filled += (unsigned long long)(std::abs(d1.x * d2.y - d1.y * d2.x) / 2);
+        }
+
+        void SDL2_Renderer::add_line(Vector2 a, Vector2 b, SDL_Color color)
+        {
+            Vector2 direction = b - a;
+            float length = direction.length();
+            // Square around the point
+            direction = length > 0.001f ? direction / length * 0.5f : Vector2{ 0.5f, 0 };
+            Vector2 normal = { -direction.y, direction.x };
+
+            // The ends are extended by half a pixel to cover the end points
+            a -= direction;
+            b += direction;
+            Vector2 corners[4] = { a + normal, b + normal, b - normal, a - normal };
+            add_quad(corners, color);
+        }
+
+        const std::vector<Vector2>& SDL2_Renderer::get_circle(float radius)
+        {
+            // Radii up to 2^bucket share the points, edges are about 2 pixels long
+            int bucket = radius > 1 ? (int)std::ceil(std::log2(radius)) : 0;
+            bucket = std::min(bucket, 12);
+            if ((int)circle_cache.size() <= bucket)
+                circle_cache.resize(bucket + 1);
+
+            std::vector<Vector2>& points = circle_cache[bucket];
+            if (points.empty())
+            {
+                int segments = (int)(M_PI * (1 << bucket));
+                segments = std::min(std::max((segments + 3) / 4 * 4, 8), 256);
+                for (int i = 0; i < segments; i++)
+                {
+                    float angle = 2 * (float)M_PI * i / segments;
+                    points.push_back({ std::cos(angle), std::sin(angle) });
+                }
+            }
+            return points;
         }
 
         SDL_Texture* SDL2_Renderer::get_texture(const Texture& texture)
@@ -445,19 +626,11 @@ namespace Sputnik
         {
             if (camera_enabled)
             {
-                pos -= camera_pos;
+                pos = camera_transform.apply(pos);
 
                 if (camera_zoom_or_angle)
                 {
-                    Vector2 surface_centre = get_surface_size().convert_to<float>() / 2;
-                    Vector2 vector = -surface_centre;
-                    vector += pos;
-                    vector = vector.rotate(camera_angle) * camera_zoom;
-                    vector += surface_centre;
-
-                    pos = vector;
                     size *= camera_zoom;
-
                     degrees += camera_angle;
                 }
             }
@@ -467,6 +640,67 @@ namespace Sputnik
                 pos = pos.floor();
         }
 
+        Vector2 SDL2_Renderer::camera_point(Vector2 point)
+        {
+            if (!camera_enabled)
+                return point;
+
+            point = camera_transform.apply(point);
+            return camera_zoom_or_angle ? point : point.floor();
+        }
+
+        void SDL2_Renderer::set_draw_color(Color color)
+        {
+            if (color.r == draw_color.r && color.g == draw_color.g
+                && color.b == draw_color.b && color.a == draw_color.a)
+            {
+                skipped_state_calls++;
+                return;
+            }
+
+            draw_color = color;
+            SDL_SetRenderDrawColor(render, color.r, color.g, color.b, color.a);
+        }
+
+        void SDL2_Renderer::set_draw_blend_mode(SDL_BlendMode mode)
+        {
+            if (mode == draw_blend_mode)
+            {
+                skipped_state_calls++;
+                return;
+            }
+
+            draw_blend_mode = mode;
+            SDL_SetRenderDrawBlendMode(render, mode);
+            counters.blend_switches++;
+        }
+
+        bool SDL2_Renderer::set_target(SDL_Texture* texture)
+        {
+            if (texture == render_target)
+            {
+                skipped_state_calls++;
+                return true;
+            }
+
+            if (SDL_SetRenderTarget(render, texture))
+                return false;
+            render_target = texture;
+            counters.target_switches++;
+            return true;
+        }
+
+        Vector2Int SDL2_Renderer::get_target_size()
+        {
+            // The output size is the window even if the target is a texture
+            Vector2Int size = {};
+            if (render_target)
+                SDL_QueryTexture(render_target, nullptr, nullptr, &size.x, &size.y);
+            else
+                SDL_GetRendererOutputSize(render, &size.x, &size.y);
+            return size;
+        }
+
         SDL_ScaleMode SDL2_Renderer::engine_to_sdl_scale(ScaleMode mode)
         {
             if (mode == ScaleMode::NEAREST)
@@ -519,7 +753,7 @@ namespace Sputnik
 
         std::unique_ptr<TextureData> SDL2_Renderer::create_texture(int w, int h, bool texture_target)
         {
-            return Utils::make_unique<SDL2_TextureData>(SDL_CreateTexture(
+            return Utils::make_unique<SDL2_TextureData>(this, SDL_CreateTexture(
                 render,
                 SDL_PIXELFORMAT_RGBA32,
                 texture_target ? SDL_TEXTUREACCESS_TARGET : 0,
@@ -528,20 +762,20 @@ namespace Sputnik
 
         std::unique_ptr<TextureData> SDL2_Renderer::create_texture(const char* filename)
         {
-            return Utils::make_unique<SDL2_TextureData>(IMG_LoadTexture(render, filename),
+            return Utils::make_unique<SDL2_TextureData>(this, IMG_LoadTexture(render, filename),
                 engine_to_sdl_scale(default_scale_mode));
         }
 
         std::unique_ptr<TextureData> SDL2_Renderer::create_texture(unsigned char* buffer, int size)
         {
-            return Utils::make_unique<SDL2_TextureData>(IMG_LoadTexture_RW(
+            return Utils::make_unique<SDL2_TextureData>(this, IMG_LoadTexture_RW(
                 render, SDL_RWFromConstMem(buffer, size), 1),
                 engine_to_sdl_scale(default_scale_mode));
         }
 
         std::unique_ptr<TextureData> SDL2_Renderer::create_texture(SDL_Surface* surface)
         {
-            return Utils::make_unique<SDL2_TextureData>(SDL_CreateTextureFromSurface(render, surface),
+            return Utils::make_unique<SDL2_TextureData>(this, SDL_CreateTextureFromSurface(render, surface),
                 engine_to_sdl_scale(default_scale_mode));
         }
 
@@ -562,80 +796,97 @@ namespace Sputnik
 
         void SDL2_Renderer::set_texture_scale_mode(Texture& texture, ScaleMode mode)
         {
-            SDL_SetTextureScaleMode(get_texture(texture), engine_to_sdl_scale(mode));
+            SDL2_TextureData& data = texture.get_data<SDL2_TextureData>();
+            SDL_ScaleMode sdl_mode = engine_to_sdl_scale(mode);
+            if (data.scale_mode == sdl_mode)
+            {
+                skipped_state_calls++;
+                return;
+            }
+
+            if (data.texture == batch_texture)
+                flush_batch();
+            SDL_SetTextureScaleMode(data.texture, data.scale_mode = sdl_mode);
         }
 
         ScaleMode SDL2_Renderer::get_texture_scale_mode(const Texture& texture)
         {
-            SDL_ScaleMode mode;
-            SDL_GetTextureScaleMode(get_texture(texture), &mode);
-            return sdl_to_engine_scale(mode);
+            return sdl_to_engine_scale(texture.get_const_data<SDL2_TextureData>().scale_mode);
         }
 
         void SDL2_Renderer::set_texture_blend_mode(Texture& texture, BlendMode mode)
         {
-            SDL_SetTextureBlendMode(get_texture(texture), engine_to_sdl_blend(mode));
+            SDL2_TextureData& data = texture.get_data<SDL2_TextureData>();
+            SDL_BlendMode sdl_mode = engine_to_sdl_blend(mode);
+            if (data.blend_mode == sdl_mode)
+            {
+                skipped_state_calls++;
+                return;
+            }
+
+            if (data.texture == batch_texture)
+                flush_batch();
+            SDL_SetTextureBlendMode(data.texture, data.blend_mode = sdl_mode);
+            counters.blend_switches++;
         }
 
         BlendMode SDL2_Renderer::get_texture_blend_mode(const Texture& texture)
         {
-            SDL_BlendMode blend_mode;
-            SDL_GetTextureBlendMode(get_texture(texture), &blend_mode);
-            return sdl_to_engine_blend(blend_mode);
+            return sdl_to_engine_blend(texture.get_const_data<SDL2_TextureData>().blend_mode);
         }
 
+        // The tint goes to the vertex colours instead of the texture colour mod
         void SDL2_Renderer::set_texture_tint(Texture& texture, Color color)
         {
-            SDL_SetTextureColorMod(get_texture(texture), color.r, color.g, color.b);
-            SDL_SetTextureAlphaMod(get_texture(texture), color.a);
+            texture.get_data<SDL2_TextureData>().tint = color;
         }
 
         Color SDL2_Renderer::get_texture_tint(const Texture& texture)
         {
-            Color color;
-            SDL_GetTextureColorMod(get_texture(texture), &color.r, &color.g, &color.b);
-            SDL_GetTextureAlphaMod(get_texture(texture), &color.a);
-            return color;
+            return texture.get_const_data<SDL2_TextureData>().tint;
         }
 
         void SDL2_Renderer::start_drawing()
         {
-            SDL_SetRenderDrawBlendMode(render, SDL_BLENDMODE_BLEND);
-            // Black bars around the surface in case of window resizing
+            counters = {};
+            set_draw_blend_mode(SDL_BLENDMODE_BLEND);
+            // Black bars around the surface in case of window resizing,
+            // the window is cleared in end_drawing() if the surface is a texture
             SDL_Rect surface_rect = { 0, 0, get_surface_size().x, get_surface_size().y };
-            SDL_SetRenderTarget(render, nullptr);
-            SDL_SetRenderDrawColor(render, 0, 0, 0, 255);
-            SDL_RenderClear(render);
+            if (screen_surface)
+            {
+                set_target(nullptr);
+                set_draw_color({ 0, 0, 0, 255 });
+                SDL_RenderClear(render);
+                counters.draw_calls++;
+            }
 
             // Actual surface clear code
             reset_render_target();
-            SDL_SetRenderDrawColor(render, bg_color.r, bg_color.g,
-                bg_color.b, bg_color.a);
+            set_draw_color(bg_color);
             SDL_RenderFillRect(render, &surface_rect);
+            counters.draw_calls++;
+            counters.pixels_filled += (unsigned long long)surface_rect.w * surface_rect.h;
 
-            SDL_SetRenderDrawBlendMode(render, primitives_blend_mode);
-
-            if (use_software_vsync)
-                frame_start = SDL_GetPerformanceCounter();
+            set_draw_blend_mode(primitives_blend_mode);
         }
 
         void SDL2_Renderer::end_drawing()
         {
+            flush_batch();
             if (!screen_surface)
             {
-                SDL_SetRenderTarget(render, nullptr);
+                set_target(nullptr);
+                set_draw_color({ 0, 0, 0, 255 });
+                SDL_RenderClear(render);
                 SDL_RenderCopy(render, surface, nullptr, nullptr);
+
+                Vector2Int size = get_target_size();
+                counters.draw_calls += 2;
+                counters.pixels_filled += (unsigned long long)size.x * size.y * 2;
             }
 
             SDL_RenderPresent(render);
-
-            if (use_software_vsync)
-            {
-                Uint64 current_frame_time = SDL_GetPerformanceCounter() - frame_start;
-                Uint32 ms = 1000.f * current_frame_time / SDL_GetPerformanceFrequency();
-                if (ms < 16)
-                    SDL_Delay(16 - ms);
-            }
         }
 
         std::string SDL2_Renderer::get_window_name()
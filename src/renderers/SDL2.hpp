@@ -4,6 +4,9 @@
 #include "Renderer.hpp"
 #include "Platform.hpp"
 
+#include <vector>
+#include <unordered_set>
+
 #if SE_SDL2 && !NO_SDL2_RENDERER
 
 #include "SDL.h"
@@ -18,11 +21,18 @@ namespace Sputnik
             class SDL2_TextureData : public TextureData
             {
             public:
-                SDL2_TextureData(SDL_Texture* texture, SDL_ScaleMode mode);
+                SDL2_TextureData(SDL2_Renderer* owner, SDL_Texture* texture, SDL_ScaleMode mode);
                 ~SDL2_TextureData() override;
 
+                // Both are nullptr once the renderer is destroyed
+                SDL2_Renderer* owner;
                 SDL_Texture* texture;
-                Vector2Int size;
+                Vector2Int size = { 0, 0 };
+                // Applied to the vertex colours of batched quads
+                Color tint = Colors::WHITE;
+                // Same as the SDL texture state, so it's not queried
+                SDL_ScaleMode scale_mode;
+                SDL_BlendMode blend_mode;
             };
             
             static std::unique_ptr<IRenderer> try_setup();
@@ -36,6 +46,7 @@ namespace Sputnik
 			std::string get_name() override;
 
 			void enable_camera(bool flag) override;
+			bool is_camera_enabled() override;
 			void apply_camera(const Camera& camera) override;
 			
 			ScaleMode get_default_scale_mode() override;
@@ -83,7 +94,11 @@ namespace Sputnik
 			void draw_texture_transform(const Texture& texture, Vector2 pos,
 				Rect texture_rect, Vector2 scale, float degrees) override;
 			
-			bool take_screenshot(const char* filename) override;
+			void read_pixels(PixelBuffer& buffer, std::function<void(bool)> done) override;
+
+            // SDL state calls skipped because they wouldn't change anything
+            unsigned long get_skipped_state_calls() const { return skipped_state_calls; }
+            void reset_skipped_state_calls() { skipped_state_calls = 0; }
 
         private:
             SDL_Window* win;
@@ -96,20 +111,64 @@ namespace Sputnik
 			SDL_BlendMode primitives_blend_mode = SDL_BLENDMODE_BLEND;
 			SDL_BlendMode subtract_blend_mode;
 			
-			Vector2 camera_pos = {};
+			// Playfield to surface, built once by apply_camera()
+			Transform2D camera_transform;
 			float camera_angle = 0; // degrees
 			float camera_zoom = 1;
 
-            Uint64 frame_start;
-			
-			bool use_software_vsync : 1,
+			bool vsync : 1,
 				screen_surface : 1,
 				camera_enabled : 1,
 				camera_zoom_or_angle : 1;
 
+            /*
+                Textured quads are collected while the texture stays the same
+                and drawn with one SDL_RenderGeometry() call. The batch is
+                flushed before anything else touches the render state.
+                Primitives are batched the same way as untextured triangles.
+            */
+            SDL_Texture* batch_texture = nullptr;
+            std::vector<SDL_Vertex> batch_vertices;
+            std::vector<int> batch_indices;
+
+            // Shadow of the SDL_Renderer state, SDL is only called when it changes
+            Color draw_color = { 0, 0, 0, 255 };
+            SDL_BlendMode draw_blend_mode = SDL_BLENDMODE_BLEND;
+            SDL_Texture* render_target = nullptr;
+            unsigned long skipped_state_calls = 0;
+
+            // Live texture data, detached when the renderer is destroyed first
+            std::unordered_set<SDL2_TextureData*> textures;
+
+            void set_draw_color(Color color);
+            void set_draw_blend_mode(SDL_BlendMode mode);
+            // Returns true if successful
+            bool set_target(SDL_Texture* texture);
+            Vector2Int get_target_size();
+
+            // Add a quad centred at pos, src is the whole texture if nullptr
+            void batch_quad(const Texture& texture, const SDL_Rect* src,
+                Vector2 pos, Vector2 size, float degrees, SDL_RendererFlip flip);
+            void flush_batch();
+
+            // Unit circle points, indexed by radius bucket (see get_circle())
+            std::vector<std::vector<Vector2>> circle_cache;
+
+            // Flush the batch if it has textured quads
+            void begin_primitives();
+            void add_vertex(Vector2 pos, SDL_Color color);
+            void add_quad(const Vector2 corners[4], SDL_Color color);
+            // One pixel wide line between surface points
+            void add_line(Vector2 a, Vector2 b, SDL_Color color);
+            // Points for a circle of the radius (in surface pixels)
+            const std::vector<Vector2>& get_circle(float radius);
+
             SDL_Texture* get_texture(const Texture& texture);
             // Position, rotate and scale the vector according to camera and the texture size
 			void camera_vector(Vector2& pos, Vector2& size, float& degrees);
+            // Playfield point to surface point
+            Vector2 camera_point(Vector2 point);
+            float camera_scale() const { return camera_zoom_or_angle ? camera_zoom : 1; }
 
 			SDL_ScaleMode engine_to_sdl_scale(ScaleMode mode);
 			ScaleMode sdl_to_engine_scale(SDL_ScaleMode mode);
@@ -27,6 +27,8 @@ namespace Sputnik
         {
             GPU_SetBlending(image, true);
             GPU_SetImageFilter(image, filter);
+            if (image)
+                set_memory_usage({ image->w, image->h }, target != nullptr);
         }
 
         SDL_GPU_Renderer::SDL_GPU_TextureData::~SDL_GPU_TextureData()
@@ -96,6 +98,8 @@ namespace Sputnik
                 case Feature::CAMERA_ZOOM:
                 case Feature::CAMERA_ROTATION:
                 case Feature::SCREENSHOT:
+                // SDL_gpu enables vsync unless GPU_INIT_DISABLE_VSYNC is passed
+                case Feature::VSYNC:
                     return true;
                 default:
                     return false;
@@ -130,13 +134,21 @@ namespace Sputnik
             }
         }
 
+        bool SDL_GPU_Renderer::is_camera_enabled()
+        {
+            // Every target has its own camera state
+            return render_target->use_camera;
+        }
+
         void SDL_GPU_Renderer::apply_camera(const Camera& cam)
         {
             GPU_Target* target = render_target;
 
-            float rad_angle = (cam.angle * M_PI) / 180.0f;
-            target->camera.x = (cos(rad_angle) * cam.offset_x() - sin(rad_angle) * cam.offset_y()) * cam.zoom;
-            target->camera.y = (sin(rad_angle) * cam.offset_x() + cos(rad_angle) * cam.offset_y()) * cam.zoom;
+            // GPU_Camera takes the offset rotated and zoomed
+            Vector2 offset = cam.get_offset(get_surface_size().convert_to<float>());
+            offset = Transform2D::rotation(cam.angle).apply_vector(offset) * cam.zoom;
+            target->camera.x = offset.x;
+            target->camera.y = offset.y;
 
             target->camera.angle = cam.angle;
             target->camera.zoom_x = cam.zoom;
@@ -169,6 +181,7 @@ namespace Sputnik
             }
             else
                 GPU_SetShapeBlendMode(engine_to_gpu_blend(mode));
+            counters.blend_switches++;
         }
 
         IWindow& SDL_GPU_Renderer::get_window()
@@ -247,6 +260,7 @@ namespace Sputnik
                 GPU_SetBlendMode(image, engine_to_gpu_blend(mode));
 
             texture.get_data<SDL_GPU_TextureData>().blend = mode;
+            counters.blend_switches++;
         }
 
         BlendMode SDL_GPU_Renderer::get_texture_blend_mode(const Texture& texture)
@@ -269,58 +283,70 @@ namespace Sputnik
         void SDL_GPU_Renderer::clear(Color color)
         {
             GPU_ClearColor(render_target, color);
+            counters.draw_calls++;
+            counters.pixels_filled += (unsigned long long)render_target->w * render_target->h;
         }
 
         void SDL_GPU_Renderer::pixel(Vector2 pos, Color color)
         {
             GPU_Pixel(render_target, pos.x, pos.y, color);
+            count_primitive(1);
         }
 
         void SDL_GPU_Renderer::line(Vector2 p1, Vector2 p2, Color color)
         {
             GPU_Line(render_target, p1.x, p1.y, p2.x, p2.y, color);
+            count_primitive(p1.distance_to(p2) + 1);
         }
 
         void SDL_GPU_Renderer::rectangle_outline(Rect rect, Color color)
         {
             GPU_Rectangle(render_target, rect.x, rect.y, rect.x + rect.w, rect.y + rect.h, color);
+            count_primitive(2 * (rect.w + rect.h));
         }
 
         void SDL_GPU_Renderer::rectangle_filled(Rect rect, Color color)
         {
             GPU_RectangleFilled(render_target, rect.x, rect.y, rect.x + rect.w, rect.y + rect.h, color);
+            count_primitive(rect.w * rect.h);
         }
 
         void SDL_GPU_Renderer::circle_outline(Vector2 centre, float radius, Color color)
         {
             GPU_Circle(render_target, centre.x, centre.y, radius, color);
+            count_primitive(2 * (float)M_PI * radius);
         }
 
         void SDL_GPU_Renderer::circle_filled(Vector2 centre, float radius, Color color)
         {
             GPU_CircleFilled(render_target, centre.x, centre.y, radius, color);
+            count_primitive((float)M_PI * radius * radius);
         }
 
         void SDL_GPU_Renderer::draw_texture(const Texture& texture, Vector2 pos)
         {
             GPU_Blit(get_image(texture), nullptr, render_target, pos.x, pos.y);
+            count_blit(texture, get_texture_size(texture).convert_to<float>());
         }
 
         void SDL_GPU_Renderer::draw_texture_scale(const Texture& texture, Vector2 pos, Vector2 scale)
         {
             GPU_BlitScale(get_image(texture), nullptr, render_target, pos.x, pos.y,
                 scale.x, scale.y);
+            count_blit(texture, get_texture_size(texture).convert_to<float>() * scale);
         }
 
         void SDL_GPU_Renderer::draw_texture_rotate(const Texture& texture, Vector2 pos, float degrees)
         {
             GPU_BlitRotate(get_image(texture), nullptr, render_target, pos.x, pos.y, degrees);
+            count_blit(texture, get_texture_size(texture).convert_to<float>());
         }
 
         void SDL_GPU_Renderer::draw_texture_part(const Texture& texture, Vector2 pos, Rect texture_rect)
         {
             GPU_Rect rect = texture_rect;
             GPU_Blit(get_image(texture), &rect, render_target, pos.x, pos.y);
+            count_blit(texture, { texture_rect.w, texture_rect.h });
         }
 
         void SDL_GPU_Renderer::draw_texture_transform(const Texture& texture, Vector2 pos,
@@ -328,6 +354,7 @@ namespace Sputnik
         {
             GPU_BlitTransform(get_image(texture), nullptr, render_target,
                 pos.x, pos.y, degrees, scale.x, scale.y);
+            count_blit(texture, get_texture_size(texture).convert_to<float>() * scale);
         }
 
         void SDL_GPU_Renderer::draw_texture_transform(const Texture& texture, Vector2 pos,
@@ -336,14 +363,30 @@ namespace Sputnik
             GPU_Rect rect = texture_rect;
             GPU_BlitTransform(get_image(texture), &rect, render_target,
                 pos.x, pos.y, degrees, scale.x, scale.y);
+            count_blit(texture, Vector2{ texture_rect.w, texture_rect.h } * scale);
         }
 
-        bool SDL_GPU_Renderer::take_screenshot(const char* filename)
+        void SDL_GPU_Renderer::read_pixels(PixelBuffer& buffer, std::function<void(bool)> done)
         {
-            GPU_Image* screenshot = GPU_CopyImageFromTarget(render_target);
-            bool result = GPU_SaveImage(screenshot, filename, GPU_FILE_AUTO);
-            GPU_FreeImage(screenshot);
-            return result;
+            SDL_Surface* copy = GPU_CopySurfaceFromTarget(render_target);
+            SDL_Surface* surface = copy ? SDL_ConvertSurfaceFormat(copy, SDL_PIXELFORMAT_RGBA32, 0) : nullptr;
+            if (copy)
+                SDL_FreeSurface(copy);
+            if (!surface)
+            {
+                Log::error(SE_FUNCTION, ": Can't read pixels: ", SDL_GetError());
+                done(false);
+                return;
+            }
+
+            buffer.size = { surface->w, surface->h };
+            buffer.pixels.resize((size_t)surface->w * surface->h);
+            for (int y = 0; y < surface->h; y++)
+                memcpy(&buffer.pixels[(size_t)y * surface->w],
+                    (const unsigned char*)surface->pixels + y * surface->pitch, surface->w * 4);
+
+            SDL_FreeSurface(surface);
+            done(true);
         }
 
         Color SDL_GPU_Renderer::get_bg_color()
@@ -361,6 +404,8 @@ namespace Sputnik
             GPU_Target* target = get_target(texture);
             if (target)
             {
+                if (render_target != target)
+                    counters.target_switches++;
                 render_target = target;
                 return true;
             }
@@ -373,7 +418,10 @@ namespace Sputnik
 
         void SDL_GPU_Renderer::reset_render_target()
         {
-            render_target = screen_surface ? screen : surface->target;
+            GPU_Target* target = screen_surface ? screen : surface->target;
+            if (render_target != target)
+                counters.target_switches++;
+            render_target = target;
         }
 
         Vector2Int SDL_GPU_Renderer::get_surface_size()
@@ -425,7 +473,11 @@ namespace Sputnik
 
         void SDL_GPU_Renderer::start_drawing()
         {
+            counters = {};
+            last_image = nullptr;
             reset_render_target();
+            counters.draw_calls++;
+            counters.pixels_filled += (unsigned long long)surface_size.x * surface_size.y;
             if (screen_surface)
             {
                 enable_camera(false);
@@ -443,6 +495,7 @@ namespace Sputnik
             {
                 GPU_Clear(screen);
                 GPU_BlitRect(surface, nullptr, screen, nullptr);
+                counters.draw_calls += 2;
             }
 
 #if SE_WINDOWS
@@ -451,6 +504,26 @@ namespace Sputnik
             GPU_Flip(screen);
         }
 
+        void SDL_GPU_Renderer::count_blit(const Texture& texture, Vector2 size)
+        {
+            GPU_Image* image = get_image(texture);
+            if (image != last_image)
+            {
+                last_image = image;
+                counters.texture_binds++;
+            }
+            counters.draw_calls++;
+            counters.textured_quads++;
+            counters.pixels_filled += (unsigned long long)std::abs(size.x * size.y);
+        }
+
+        void SDL_GPU_Renderer::count_primitive(float area)
+        {
+            counters.draw_calls++;
+            counters.primitives++;
+            counters.pixels_filled += (unsigned long long)std::abs(area);
+        }
+
         GPU_Image* SDL_GPU_Renderer::get_image(const Texture& texture)
         {
             return texture.get_const_data<SDL_GPU_TextureData>().image;
@@ -37,6 +37,7 @@ namespace Sputnik
             std::string get_name() override;
             
 			void enable_camera(bool flag) override;
+			bool is_camera_enabled() override;
             void apply_camera(const Camera& camera) override;
             
             ScaleMode get_default_scale_mode() override;
@@ -77,7 +78,7 @@ namespace Sputnik
 			void draw_texture_transform(const Texture& texture, Vector2 pos,
                 Rect texture_rect, Vector2 scale, float degrees) override;
             
-            bool take_screenshot(const char* filename) override;
+            void read_pixels(PixelBuffer& buffer, std::function<void(bool)> done) override;
 
         private:
             SDL_Window* win;
@@ -93,7 +94,13 @@ namespace Sputnik
             
             bool screen_surface : 1;
 
+            // Last image drawn, for FrameCounters
+            GPU_Image* last_image = nullptr;
+
             GPU_Image* get_image(const Texture& texture);
+            // Count a blit of the texture, size is in texture pixels
+            void count_blit(const Texture& texture, Vector2 size);
+            void count_primitive(float area);
             GPU_Target* get_target(const Texture& texture);
 
             GPU_FilterEnum engine_to_gpu_filter(ScaleMode mode);
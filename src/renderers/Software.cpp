@@ -0,0 +1,825 @@
+#include "Software.hpp"
+#include "SoftwareBlit.hpp"
+
+#include "Platform.hpp"
+#include "Scene.hpp"
+#include "Utils.hpp"
+#include "config.hpp"
+
+#if !NO_SOFTWARE_RENDERER
+
+#if SE_SDL2
+#include "SDL_image.h"
+#elif SE_LIBPNG
+#include <png.h>
+#endif
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+namespace Sputnik
+{
+    namespace Renderer
+    {
+        namespace
+        {
+            // Narrow [lo, hi) to the pixel centres x + 0.5 where 0 <= start + step * x < limit
+            void clip_span(float start, float step, float limit, float& lo, float& hi)
+            {
+                if (step == 0)
+                {
+                    if (start < 0 || start >= limit)
+                        hi = lo;
+                    return;
+                }
+
+                float a = -start / step;
+                float b = (limit - start) / step;
+                if (a > b)
+                    std::swap(a, b);
+
+                lo = std::max(lo, a);
+                hi = std::min(hi, b);
+            }
+        }
+
+        void Software_Renderer::Surface::resize(int w, int h)
+        {
+            width = std::max(w, 0);
+            height = std::max(h, 0);
+            pixels.assign((size_t)width * height, Colors::NONE);
+        }
+
+        std::unique_ptr<IRenderer> Software_Renderer::try_setup()
+        {
+            return Utils::make_unique<Software_Renderer>();
+        }
+
+        Software_Renderer::Software_Renderer()
+            : target(&surface), window_name(GAME_NAME), window_resolution(WINDOW_SIZE)
+        {
+            surface.resize(SURFACE_SIZE.x, SURFACE_SIZE.y);
+        }
+
+        bool Software_Renderer::is_feature_supported(Feature feature)
+        {
+            switch (feature)
+            {
+                case Feature::RENDER_TARGET:
+                case Feature::CAMERA_ZOOM:
+                case Feature::CAMERA_ROTATION:
+                case Feature::SCREENSHOT:
+                // It only touches its own memory
+                case Feature::RENDER_THREAD:
+                    return true;
+
+                // IRenderer has no shader interface yet
+                case Feature::SHADERS:
+                default:
+                    return false;
+            }
+        }
+
+        bool Software_Renderer::is_blend_mode_supported(BlendMode /*mode*/)
+        {
+            return true;
+        }
+
+        std::string Software_Renderer::get_name()
+        {
+            return "Software";
+        }
+
+        void Software_Renderer::enable_camera(bool flag)
+        {
+            camera_enabled = flag;
+            camera_zoom_or_angle = flag && ((camera_zoom != 1) || (camera_angle != 0));
+        }
+
+        bool Software_Renderer::is_camera_enabled()
+        {
+            return camera_enabled;
+        }
+
+        void Software_Renderer::apply_camera(const Camera& camera)
+        {
+            camera_transform = camera.get_transform(get_surface_size().convert_to<float>());
+            camera_angle = camera.angle;
+            camera_zoom = camera.zoom;
+
+            camera_zoom_or_angle = camera_enabled && ((camera_zoom != 1) || (camera_angle != 0));
+        }
+
+        ScaleMode Software_Renderer::get_default_scale_mode()
+        {
+            return default_scale_mode;
+        }
+
+        void Software_Renderer::set_default_scale_mode(ScaleMode mode)
+        {
+            default_scale_mode = mode;
+        }
+
+        IWindow& Software_Renderer::get_window()
+        {
+            return *this;
+        }
+
+        Color Software_Renderer::get_bg_color()
+        {
+            return bg_color;
+        }
+
+        void Software_Renderer::set_bg_color(Color color)
+        {
+            bg_color = color;
+        }
+
+        bool Software_Renderer::set_render_target(Texture& texture)
+        {
+            Surface* image = &get_data(texture).image;
+            if (target != image)
+                counters.target_switches++;
+            target = image;
+            return true;
+        }
+
+        void Software_Renderer::reset_render_target()
+        {
+            if (target != &surface)
+                counters.target_switches++;
+            target = &surface;
+        }
+
+        Vector2Int Software_Renderer::get_surface_size()
+        {
+            return { surface.width, surface.height };
+        }
+
+        void Software_Renderer::set_surface_size(int w, int h)
+        {
+            surface.resize(w, h);
+        }
+
+        bool Software_Renderer::use_screen_surface(bool /*flag*/)
+        {
+            // There is no screen, the surface is always used
+            return true;
+        }
+
+        bool Software_Renderer::use_window(int id)
+        {
+            return id == 0;
+        }
+
+        BlendMode Software_Renderer::get_primitives_blend_mode()
+        {
+            return primitives_blend_mode;
+        }
+
+        void Software_Renderer::set_primitives_blend_mode(BlendMode mode)
+        {
+            primitives_blend_mode = mode;
+        }
+
+        void Software_Renderer::clear(Color color)
+        {
+            std::fill(target->pixels.begin(), target->pixels.end(), color);
+            counters.draw_calls++;
+            counters.pixels_filled += target->pixels.size();
+        }
+
+        // Primitives are drawn in playfield coordinates like the textures
+
+        void Software_Renderer::pixel(Vector2 pos, Color color)
+        {
+            count_draw(nullptr, primitives_blend_mode);
+            Vector2 p = camera_point(pos);
+            plot((int)std::floor(p.x), (int)std::floor(p.y), color);
+        }
+
+        void Software_Renderer::line(Vector2 p1, Vector2 p2, Color color)
+        {
+            count_draw(nullptr, primitives_blend_mode);
+            plot_line(camera_point(p1), camera_point(p2), color);
+        }
+
+        void Software_Renderer::rectangle_outline(Rect rect, Color color)
+        {
+            count_draw(nullptr, primitives_blend_mode);
+            if (camera_zoom_or_angle)
+            {
+                Vector2 corners[4] = {
+                    camera_point({ rect.x, rect.y }), camera_point({ rect.x + rect.w - 1, rect.y }),
+                    camera_point({ rect.x + rect.w - 1, rect.y + rect.h - 1 }), camera_point({ rect.x, rect.y + rect.h - 1 }),
+                };
+                for (int i = 0; i < 4; i++)
+                    plot_line(corners[i], corners[(i + 1) % 4], color);
+                return;
+            }
+
+            Vector2 pos = camera_point({ rect.x, rect.y });
+            int x0 = (int)pos.x, y0 = (int)pos.y;
+            int x1 = x0 + (int)rect.w - 1, y1 = y0 + (int)rect.h - 1;
+            if (x1 < x0 || y1 < y0)
+                return;
+
+            fill_span(y0, x0, x1 + 1, color);
+            if (y1 != y0)
+                fill_span(y1, x0, x1 + 1, color);
+            for (int y = y0 + 1; y < y1; y++)
+            {
+                plot(x0, y, color);
+                if (x1 != x0)
+                    plot(x1, y, color);
+            }
+        }
+
+        void Software_Renderer::rectangle_filled(Rect rect, Color color)
+        {
+            count_draw(nullptr, primitives_blend_mode);
+            if (camera_zoom_or_angle)
+            {
+                Vector2 corners[4] = {
+                    camera_point({ rect.x, rect.y }), camera_point({ rect.x + rect.w, rect.y }),
+                    camera_point({ rect.x + rect.w, rect.y + rect.h }), camera_point({ rect.x, rect.y + rect.h }),
+                };
+                fill_polygon(corners, 4, color);
+                return;
+            }
+
+            Vector2 pos = camera_point({ rect.x, rect.y });
+            int x0 = (int)pos.x, y0 = (int)pos.y;
+            for (int y = y0; y < y0 + (int)rect.h; y++)
+                fill_span(y, x0, x0 + (int)rect.w, color);
+        }
+
+        void Software_Renderer::circle_outline(Vector2 centre, float radius, Color color)
+        {
+            count_draw(nullptr, primitives_blend_mode);
+            // Midpoint circle algorithm, every octant point is drawn once
+            Vector2 c = camera_point(centre);
+            int cx = (int)std::floor(c.x), cy = (int)std::floor(c.y);
+            int x = (int)(camera_zoom_or_angle ? radius * camera_zoom : radius), y = 0;
+            int error = 1 - x;
+
+            while (x >= y)
+            {
+                int points[8][2] = {
+                    { x, y }, { y, x }, { -y, x }, { -x, y },
+                    { -x, -y }, { -y, -x }, { y, -x }, { x, -y },
+                };
+
+                for (int i = 0; i < 8; i++)
+                {
+                    // Skip the duplicates on the axes and diagonals
+                    bool duplicate = false;
+                    for (int j = 0; j < i && !duplicate; j++)
+                        duplicate = points[i][0] == points[j][0] && points[i][1] == points[j][1];
+
+                    if (!duplicate)
+                        plot(cx + points[i][0], cy + points[i][1], color);
+                }
+
+                y++;
+                if (error < 0)
+                    error += 2 * y + 1;
+                else
+                {
+                    x--;
+                    error += 2 * (y - x) + 1;
+                }
+            }
+        }
+
+        void Software_Renderer::circle_filled(Vector2 centre, float radius, Color color)
+        {
+            count_draw(nullptr, primitives_blend_mode);
+            Vector2 c = camera_point(centre);
+            int cx = (int)std::floor(c.x), cy = (int)std::floor(c.y);
+            int r = (int)(camera_zoom_or_angle ? radius * camera_zoom : radius);
+
+            for (int dy = -r; dy <= r; dy++)
+            {
+                int half = (int)std::sqrt((float)(r * r - dy * dy));
+                fill_span(cy + dy, cx - half, cx + half + 1, color);
+            }
+        }
+
+        void Software_Renderer::plot(int x, int y, Color color)
+        {
+            if (x >= 0 && y >= 0 && x < target->width && y < target->height)
+            {
+                Blit::blend_pixel(target->row(y)[x], color, primitives_blend_mode);
+                counters.pixels_filled++;
+            }
+        }
+
+        void Software_Renderer::plot_line(Vector2 p1, Vector2 p2, Color color)
+        {
+            // Bresenham's line algorithm
+            int x0 = (int)std::floor(p1.x), y0 = (int)std::floor(p1.y);
+            int x1 = (int)std::floor(p2.x), y1 = (int)std::floor(p2.y);
+            int dx = std::abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
+            int dy = -std::abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
+            int error = dx + dy;
+
+            while (true)
+            {
+                plot(x0, y0, color);
+                if (x0 == x1 && y0 == y1)
+                    break;
+
+                int e2 = error * 2;
+                if (e2 >= dy)
+                {
+                    error += dy;
+                    x0 += sx;
+                }
+                if (e2 <= dx)
+                {
+                    error += dx;
+                    y0 += sy;
+                }
+            }
+        }
+
+        void Software_Renderer::fill_span(int y, int x0, int x1, Color color)
+        {
+            if (y < 0 || y >= target->height)
+                return;
+
+            x0 = std::max(x0, 0);
+            x1 = std::min(x1, target->width);
+
+            Color* row = target->row(y);
+            for (int x = x0; x < x1; x++)
+                Blit::blend_pixel(row[x], color, primitives_blend_mode);
+            if (x1 > x0)
+                counters.pixels_filled += x1 - x0;
+        }
+
+        void Software_Renderer::fill_polygon(const Vector2* corners, int count, Color color)
+        {
+            float top = corners[0].y, bottom = corners[0].y;
+            for (int i = 1; i < count; i++)
+            {
+                top = std::min(top, corners[i].y);
+                bottom = std::max(bottom, corners[i].y);
+            }
+
+            // Pixels whose centre is inside, a convex polygon crosses a row twice
+            int y0 = std::max((int)std::ceil(top - 0.5f), 0);
+            int y1 = std::min((int)std::ceil(bottom - 0.5f), target->height);
+            for (int y = y0; y < y1; y++)
+            {
+                float row_y = y + 0.5f;
+                float left = (float)target->width, right = 0;
+                for (int i = 0; i < count; i++)
+                {
+                    Vector2 a = corners[i], b = corners[(i + 1) % count];
+                    if ((a.y <= row_y) == (b.y <= row_y))
+                        continue;
+
+                    float x = a.x + (row_y - a.y) / (b.y - a.y) * (b.x - a.x);
+                    left = std::min(left, x);
+                    right = std::max(right, x);
+                }
+
+                if (left < right)
+                    fill_span(y, (int)std::ceil(left - 0.5f), (int)std::ceil(right - 0.5f), color);
+            }
+        }
+
+        void Software_Renderer::draw_texture(const Texture& texture, Vector2 pos)
+        {
+            draw_quad(texture, nullptr, pos, { 1, 1 }, 0);
+        }
+
+        void Software_Renderer::draw_texture_scale(const Texture& texture, Vector2 pos, Vector2 scale)
+        {
+            draw_quad(texture, nullptr, pos, scale, 0);
+        }
+
+        void Software_Renderer::draw_texture_rotate(const Texture& texture, Vector2 pos, float degrees)
+        {
+            draw_quad(texture, nullptr, pos, { 1, 1 }, degrees);
+        }
+
+        void Software_Renderer::draw_texture_part(const Texture& texture, Vector2 pos, Rect texture_rect)
+        {
+            draw_quad(texture, &texture_rect, pos, { 1, 1 }, 0);
+        }
+
+        void Software_Renderer::draw_texture_transform(const Texture& texture, Vector2 pos,
+            Vector2 scale, float degrees)
+        {
+            draw_quad(texture, nullptr, pos, scale, degrees);
+        }
+
+        void Software_Renderer::draw_texture_transform(const Texture& texture, Vector2 pos,
+            Rect texture_rect, Vector2 scale, float degrees)
+        {
+            draw_quad(texture, &texture_rect, pos, scale, degrees);
+        }
+
+        void Software_Renderer::draw_quad(const Texture& texture, const Rect* src, Vector2 pos,
+            Vector2 scale, float degrees)
+        {
+            const Software_TextureData& data = get_data(texture);
+            const Surface& img = data.image;
+
+            // Integer source rectangle like SDL_Rect, clamped to the image
+            int src_x = 0, src_y = 0, src_w = img.width, src_h = img.height;
+            if (src)
+            {
+                src_x = (int)src->x;
+                src_y = (int)src->y;
+                src_w = (int)src->w;
+                src_h = (int)src->h;
+            }
+
+            Blit::Area area = {
+                std::max(src_x, 0), std::max(src_y, 0),
+                std::min(src_x + src_w, img.width) - 1, std::min(src_y + src_h, img.height) - 1,
+            };
+            if (area.x1 < area.x0 || area.y1 < area.y0 || scale.x == 0 || scale.y == 0)
+                return;
+
+            bool flip_x = scale.x < 0, flip_y = scale.y < 0;
+            Vector2 size = { src_w * std::fabs(scale.x), src_h * std::fabs(scale.y) };
+
+            // pos becomes the top left corner of the unrotated quad
+            camera_vector(pos, size, degrees);
+            if (size.x <= 0 || size.y <= 0)
+                return;
+
+            count_draw(&data, data.blend_mode);
+            counters.textured_quads++;
+
+            Vector2 half = size / 2;
+            Vector2 centre = pos + half;
+
+            float rad = degrees * M_PI / 180.0;
+            float sin_value = std::sin(rad), cos_value = std::cos(rad);
+
+            // Texel coordinates change linearly over the target:
+            // uv = origin + step_x * X + step_y * Y for a pixel centre (X, Y)
+            float scale_u = src_w / size.x, scale_v = src_h / size.y;
+            float u_step_x = cos_value * scale_u, u_step_y = sin_value * scale_u;
+            float v_step_x = -sin_value * scale_v, v_step_y = cos_value * scale_v;
+            float u_origin = (half.x - cos_value * centre.x - sin_value * centre.y) * scale_u;
+            float v_origin = (half.y + sin_value * centre.x - cos_value * centre.y) * scale_v;
+
+            if (flip_x)
+            {
+                u_origin = src_w - u_origin;
+                u_step_x = -u_step_x;
+                u_step_y = -u_step_y;
+            }
+            if (flip_y)
+            {
+                v_origin = src_h - v_origin;
+                v_step_x = -v_step_x;
+                v_step_y = -v_step_y;
+            }
+
+            // Vertical extent of the rotated quad
+            float extent_y = std::fabs(half.x * sin_value) + std::fabs(half.y * cos_value);
+            int y_begin = std::max(0, (int)std::ceil(centre.y - extent_y - 0.5f));
+            int y_end = std::min(target->height, (int)std::ceil(centre.y + extent_y - 0.5f));
+
+            Blit::Span span;
+            span.image = img.pixels.data();
+            span.pitch = img.width;
+            span.area = area;
+            span.du = u_step_x;
+            span.dv = v_step_x;
+            span.tint = data.tint;
+            span.blend_mode = data.blend_mode;
+            span.scale_mode = data.scale_mode;
+            Blit::Kernel kernel = Blit::get_kernel();
+
+            for (int y = y_begin; y < y_end; y++)
+            {
+                float row_y = y + 0.5f;
+                float u_row = u_origin + u_step_y * row_y;
+                float v_row = v_origin + v_step_y * row_y;
+
+                float lo = 0, hi = (float)target->width;
+                clip_span(u_row, u_step_x, (float)src_w, lo, hi);
+                clip_span(v_row, v_step_x, (float)src_h, lo, hi);
+
+                int x_begin = std::max(0, (int)std::ceil(lo - 0.5f));
+                int x_end = std::min(target->width, (int)std::ceil(hi - 0.5f));
+                if (x_begin >= x_end)
+                    continue;
+
+                span.u = src_x + u_row + u_step_x * (x_begin + 0.5f);
+                span.v = src_y + v_row + v_step_x * (x_begin + 0.5f);
+                kernel(target->row(y) + x_begin, x_end - x_begin, span);
+                counters.pixels_filled += x_end - x_begin;
+            }
+        }
+
+        void Software_Renderer::read_pixels(PixelBuffer& buffer, std::function<void(bool)> done)
+        {
+            buffer.size = { target->width, target->height };
+            buffer.pixels.resize(target->pixels.size());
+            std::copy(target->pixels.begin(), target->pixels.end(), buffer.pixels.begin());
+            done(true);
+        }
+
+        void Software_Renderer::start_drawing()
+        {
+            counters = {};
+            last_texture = nullptr;
+            reset_render_target();
+            std::fill(surface.pixels.begin(), surface.pixels.end(), bg_color);
+            counters.draw_calls++;
+            counters.pixels_filled += surface.pixels.size();
+        }
+
+        void Software_Renderer::end_drawing()
+        {
+            frame_count++;
+        }
+
+        Software_Renderer::Software_TextureData& Software_Renderer::get_data(const Texture& texture)
+        {
+            return const_cast<Software_TextureData&>(texture.get_const_data<Software_TextureData>());
+        }
+
+        void Software_Renderer::count_draw(const Software_TextureData* texture, BlendMode mode)
+        {
+            counters.draw_calls++;
+            if (!texture)
+                counters.primitives++;
+            else if (texture != last_texture)
+            {
+                last_texture = texture;
+                counters.texture_binds++;
+            }
+            if (mode != last_blend_mode)
+            {
+                last_blend_mode = mode;
+                counters.blend_switches++;
+            }
+        }
+
+        void Software_Renderer::camera_vector(Vector2& pos, Vector2& size, float& degrees)
+        {
+            if (camera_enabled)
+            {
+                pos = camera_transform.apply(pos);
+
+                if (camera_zoom_or_angle)
+                {
+                    size *= camera_zoom;
+                    degrees += camera_angle;
+                }
+            }
+
+            pos -= size / 2;
+            if (!camera_zoom_or_angle)
+                pos = pos.floor();
+        }
+
+        Vector2 Software_Renderer::camera_point(Vector2 point)
+        {
+            if (!camera_enabled)
+                return point;
+
+            point = camera_transform.apply(point);
+            return camera_zoom_or_angle ? point : point.floor();
+        }
+
+        std::unique_ptr<TextureData> Software_Renderer::create_texture(int w, int h, bool texture_target)
+        {
+            // Every texture can be a render target here
+            auto data = Utils::make_unique<Software_TextureData>();
+            data->image.resize(w, h);
+            data->scale_mode = default_scale_mode;
+            data->set_memory_usage({ w, h }, texture_target);
+            return data;
+        }
+
+#if SE_SDL2
+        std::unique_ptr<TextureData> Software_Renderer::create_texture(const char* filename)
+        {
+            SDL_Surface* image = IMG_Load(filename);
+            if (!image)
+            {
+                Log::error(SE_FUNCTION, ": Can't load image '", filename, "': ", IMG_GetError());
+                return create_texture(0, 0, false);
+            }
+
+            auto data = create_texture(image);
+            SDL_FreeSurface(image);
+            return data;
+        }
+
+        std::unique_ptr<TextureData> Software_Renderer::create_texture(unsigned char* buffer, int size)
+        {
+            SDL_Surface* image = IMG_Load_RW(SDL_RWFromConstMem(buffer, size), 1);
+            if (!image)
+            {
+                Log::error(SE_FUNCTION, ": Can't load image from buffer: ", IMG_GetError());
+                return create_texture(0, 0, false);
+            }
+
+            auto data = create_texture(image);
+            SDL_FreeSurface(image);
+            return data;
+        }
+
+        std::unique_ptr<TextureData> Software_Renderer::create_texture(SDL_Surface* surface)
+        {
+            SDL_Surface* rgba = SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA32, 0);
+            if (!rgba)
+            {
+                Log::error(SE_FUNCTION, ": Can't convert the surface: ", SDL_GetError());
+                return create_texture(0, 0, false);
+            }
+
+            auto data = Utils::make_unique<Software_TextureData>();
+            data->image.resize(rgba->w, rgba->h);
+            data->scale_mode = default_scale_mode;
+            data->set_memory_usage({ rgba->w, rgba->h }, false);
+
+            SDL_LockSurface(rgba);
+            for (int y = 0; y < rgba->h; y++)
+                std::copy_n((const Color*)((const uint8_t*)rgba->pixels + y * rgba->pitch),
+                    rgba->w, data->image.row(y));
+            SDL_UnlockSurface(rgba);
+
+            SDL_FreeSurface(rgba);
+            return data;
+        }
+#elif SE_LIBPNG
+        namespace
+        {
+            // Finish reading a png_image opened by png_image_begin_read_*()
+            bool read_png(png_image& png, Software_Renderer::Surface& image)
+            {
+                if (PNG_IMAGE_FAILED(png))
+                    return false;
+
+                png.format = PNG_FORMAT_RGBA;
+                image.resize(png.width, png.height);
+                if (png_image_finish_read(&png, nullptr, image.pixels.data(), 0, nullptr))
+                    return true;
+
+                image.resize(0, 0);
+                return false;
+            }
+        }
+
+        std::unique_ptr<TextureData> Software_Renderer::create_texture(const char* filename)
+        {
+            png_image png = {};
+            png.version = PNG_IMAGE_VERSION;
+            png_image_begin_read_from_file(&png, filename);
+
+            auto data = Utils::make_unique<Software_TextureData>();
+            if (!read_png(png, data->image))
+            {
+                Log::error(SE_FUNCTION, ": Can't load image '", filename, "': ", png.message);
+                png_image_free(&png);
+            }
+
+            data->scale_mode = default_scale_mode;
+            data->set_memory_usage({ data->image.width, data->image.height }, false);
+            return data;
+        }
+
+        std::unique_ptr<TextureData> Software_Renderer::create_texture(unsigned char* buffer, int size)
+        {
+            png_image png = {};
+            png.version = PNG_IMAGE_VERSION;
+            png_image_begin_read_from_memory(&png, buffer, size);
+
+            auto data = Utils::make_unique<Software_TextureData>();
+            if (!read_png(png, data->image))
+            {
+                Log::error(SE_FUNCTION, ": Can't load image from buffer: ", png.message);
+                png_image_free(&png);
+            }
+
+            data->scale_mode = default_scale_mode;
+            data->set_memory_usage({ data->image.width, data->image.height }, false);
+            return data;
+        }
+#else
+        // Image decoding needs SDL_image or libpng, without them the textures stay empty
+        std::unique_ptr<TextureData> Software_Renderer::create_texture(const char* filename)
+        {
+            Log::error(SE_FUNCTION, ": Can't load image '", filename, "' without SDL_image or libpng");
+            return create_texture(0, 0, false);
+        }
+
+        std::unique_ptr<TextureData> Software_Renderer::create_texture(unsigned char* /*buffer*/, int /*size*/)
+        {
+            Log::error(SE_FUNCTION, ": Can't load image from buffer without SDL_image or libpng");
+            return create_texture(0, 0, false);
+        }
+#endif
+
+        int Software_Renderer::get_texture_width(const Texture& texture)
+        {
+            return get_data(texture).image.width;
+        }
+
+        int Software_Renderer::get_texture_height(const Texture& texture)
+        {
+            return get_data(texture).image.height;
+        }
+
+        Vector2Int Software_Renderer::get_texture_size(const Texture& texture)
+        {
+            return { get_data(texture).image.width, get_data(texture).image.height };
+        }
+
+        void Software_Renderer::set_texture_scale_mode(Texture& texture, ScaleMode mode)
+        {
+            get_data(texture).scale_mode = mode;
+        }
+
+        ScaleMode Software_Renderer::get_texture_scale_mode(const Texture& texture)
+        {
+            return get_data(texture).scale_mode;
+        }
+
+        void Software_Renderer::set_texture_blend_mode(Texture& texture, BlendMode mode)
+        {
+            get_data(texture).blend_mode = mode;
+        }
+
+        BlendMode Software_Renderer::get_texture_blend_mode(const Texture& texture)
+        {
+            return get_data(texture).blend_mode;
+        }
+
+        void Software_Renderer::set_texture_tint(Texture& texture, Color color)
+        {
+            get_data(texture).tint = color;
+        }
+
+        Color Software_Renderer::get_texture_tint(const Texture& texture)
+        {
+            return get_data(texture).tint;
+        }
+
+        std::string Software_Renderer::get_window_name()
+        {
+            return window_name;
+        }
+
+        void Software_Renderer::set_window_name(const char* name)
+        {
+            window_name = name;
+        }
+
+        Vector2Int Software_Renderer::get_window_resolution()
+        {
+            return window_resolution;
+        }
+
+        void Software_Renderer::set_window_resolution(int w, int h)
+        {
+            window_resolution = { w, h };
+        }
+
+        void Software_Renderer::handle_resolution_update(int /*w*/, int /*h*/) {}
+
+        Vector2Int Software_Renderer::get_window_position()
+        {
+            return window_position;
+        }
+
+        void Software_Renderer::set_window_position(int x, int y)
+        {
+            window_position = { x, y };
+        }
+
+        void Software_Renderer::center_window()
+        {
+            window_position = {};
+        }
+
+        void Software_Renderer::set_resizable(bool /*enable*/) {}
+
+        void Software_Renderer::set_fullscreen(bool flag)
+        {
+            fullscreen = flag;
+        }
+
+        bool Software_Renderer::get_fullscreen()
+        {
+            return fullscreen;
+        }
+    }
+}
+
+#endif
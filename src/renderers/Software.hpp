@@ -0,0 +1,196 @@
+#ifndef __SOFTWARE_H__
+#define __SOFTWARE_H__
+
+#include "Renderer.hpp"
+#include "Platform.hpp"
+
+#if !NO_SOFTWARE_RENDERER
+
+#include <vector>
+#include <string>
+
+namespace Sputnik
+{
+    namespace Renderer
+    {
+        /*
+            Renderer that rasterizes into an in-memory RGBA surface on the CPU.
+            It needs neither a GPU nor a display (the window is only emulated),
+            so it's meant for benchmarks and comparing frames in tests.
+        */
+        class Software_Renderer final : public IRenderer, public IWindow
+        {
+        public:
+            // RGBA image, rows are stored top to bottom without padding
+            struct Surface
+            {
+                int width = 0;
+                int height = 0;
+                std::vector<Color> pixels;
+
+                void resize(int w, int h);
+                Color* row(int y) { return pixels.data() + (size_t)y * width; }
+                const Color* row(int y) const { return pixels.data() + (size_t)y * width; }
+            };
+
+            class Software_TextureData : public TextureData
+            {
+            public:
+                Surface image;
+                ScaleMode scale_mode;
+                BlendMode blend_mode = BlendMode::NORMAL;
+                Color tint = Colors::WHITE;
+            };
+
+            static std::unique_ptr<IRenderer> try_setup();
+
+            Software_Renderer();
+
+			bool is_feature_supported(Feature feature) override;
+			bool is_blend_mode_supported(BlendMode mode) override;
+
+			std::string get_name() override;
+
+			void enable_camera(bool flag) override;
+			bool is_camera_enabled() override;
+			void apply_camera(const Camera& camera) override;
+
+			ScaleMode get_default_scale_mode() override;
+			void set_default_scale_mode(ScaleMode mode) override;
+
+            IWindow& get_window() override;
+
+			/* Rendering */
+
+			Color get_bg_color() override;
+			void set_bg_color(Color color) override;
+
+			bool set_render_target(Texture& texture) override;
+			void reset_render_target() override;
+
+			Vector2Int get_surface_size() override;
+			void set_surface_size(int w, int h) override;
+			bool use_screen_surface(bool flag) override;
+            bool use_window(int id) override;
+
+			BlendMode get_primitives_blend_mode() override;
+			void set_primitives_blend_mode(BlendMode mode) override;
+
+			void clear(Color color = Colors::NONE) override;
+			void pixel(Vector2 pos, Color color) override;
+			void line(Vector2 p1, Vector2 p2, Color color) override;
+			void rectangle_outline(Rect rect, Color color) override;
+			void rectangle_filled(Rect rect, Color color) override;
+			void circle_outline(Vector2 centre, float radius, Color color) override;
+			void circle_filled(Vector2 centre, float radius, Color color) override;
+
+			void draw_texture(const Texture& texture, Vector2 pos) override;
+			void draw_texture_scale(const Texture& texture, Vector2 pos, Vector2 scale) override;
+			void draw_texture_rotate(const Texture& texture, Vector2 pos, float degrees) override;
+			void draw_texture_part(const Texture& texture, Vector2 pos, Rect texture_rect) override;
+			void draw_texture_transform(const Texture& texture, Vector2 pos,
+				Vector2 scale, float degrees) override;
+			void draw_texture_transform(const Texture& texture, Vector2 pos,
+				Rect texture_rect, Vector2 scale, float degrees) override;
+
+			// Saves a PNG if SDL_image is available, otherwise a PAM image
+			void read_pixels(PixelBuffer& buffer, std::function<void(bool)> done) override;
+
+            // The surface as it is after the last end_drawing()
+            const Surface& get_surface() const { return surface; }
+            // Frames finished since the renderer was created
+            unsigned long get_frame_count() const { return frame_count; }
+
+			void start_drawing() override;
+			void end_drawing() override;
+
+			/* Window methods, they only keep the values */
+
+			std::string get_window_name() override;
+			void set_window_name(const char* name) override;
+
+			Vector2Int get_window_resolution() override;
+            void set_window_resolution(int w, int h) override;
+            void handle_resolution_update(int w, int h) override;
+
+			Vector2Int get_window_position() override;
+			void set_window_position(int x, int y) override;
+			void center_window() override;
+
+			void set_resizable(bool enable) override;
+
+			void set_fullscreen(bool flag) override;
+			bool get_fullscreen() override;
+
+        private:
+            Surface surface;
+            // The surface or the image of a texture
+            Surface* target;
+
+			Color bg_color = Colors::BLACK;
+			ScaleMode default_scale_mode = ScaleMode::NEAREST;
+			BlendMode primitives_blend_mode = BlendMode::NORMAL;
+
+			// Playfield to surface, built once by apply_camera()
+			Transform2D camera_transform;
+			float camera_angle = 0; // degrees
+			float camera_zoom = 1;
+			bool camera_enabled = true;
+			bool camera_zoom_or_angle = false;
+
+            std::string window_name;
+            Vector2Int window_resolution;
+            Vector2Int window_position = {};
+            bool fullscreen = false;
+
+            unsigned long frame_count = 0;
+            // Last state drawn with, for FrameCounters
+            const Software_TextureData* last_texture = nullptr;
+            BlendMode last_blend_mode = BlendMode::NORMAL;
+
+            Software_TextureData& get_data(const Texture& texture);
+            // Count a drawing call and the state changes it needs,
+            // texture is nullptr for primitives
+            void count_draw(const Software_TextureData* texture, BlendMode mode);
+            // Position, rotate and scale the vector according to camera and the texture size
+			void camera_vector(Vector2& pos, Vector2& size, float& degrees);
+            // Draw the src part of the texture centred at pos
+            void draw_quad(const Texture& texture, const Rect* src, Vector2 pos,
+                Vector2 scale, float degrees);
+            // Playfield point to surface point
+            Vector2 camera_point(Vector2 point);
+            // Primitives in surface pixels
+            void plot(int x, int y, Color color);
+            void plot_line(Vector2 p1, Vector2 p2, Color color);
+            void fill_span(int y, int x0, int x1, Color color);
+            // Convex polygon, the corners are in surface pixels
+            void fill_polygon(const Vector2* corners, int count, Color color);
+
+			/* Texture methods */
+
+            std::unique_ptr<TextureData> create_texture(int w, int h, bool texture_target) override;
+            std::unique_ptr<TextureData> create_texture(const char* filename) override;
+            std::unique_ptr<TextureData> create_texture(unsigned char* buffer, int size) override;
+#if SE_SDL2
+			std::unique_ptr<TextureData> create_texture(SDL_Surface* surface) override;
+#endif
+
+			int get_texture_width(const Texture& texture) override;
+            int get_texture_height(const Texture& texture) override;
+			Vector2Int get_texture_size(const Texture& texture) override;
+
+			void set_texture_scale_mode(Texture& texture, ScaleMode mode) override;
+			ScaleMode get_texture_scale_mode(const Texture& texture) override;
+
+			void set_texture_blend_mode(Texture& texture, BlendMode mode) override;
+			BlendMode get_texture_blend_mode(const Texture& texture) override;
+
+			void set_texture_tint(Texture& texture, Color color) override;
+            Color get_texture_tint(const Texture& texture) override;
+		};
+    }
+}
+
+#endif
+
+#endif // __SOFTWARE_H__
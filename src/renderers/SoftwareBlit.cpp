@@ -0,0 +1,481 @@
+#include "SoftwareBlit.hpp"
+
+#include "Platform.hpp"
+
+#if !NO_SOFTWARE_RENDERER
+
+#include <cstring>
+
+#if SE_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 kernels are compiled for x86 even without -mavx2 and only used if the CPU has it
+#if SE_SSE2 && (defined(__GNUC__) || defined(_MSC_VER))
+#define BLIT_AVX2 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define BLIT_TARGET_AVX2
+#else
+#define BLIT_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define BLIT_AVX2 0
+#endif
+
+namespace Sputnik
+{
+    namespace Renderer
+    {
+        namespace Blit
+        {
+            namespace
+            {
+                bool force_scalar = false;
+
+                inline uint32_t load_pixel(const Color* p)
+                {
+                    uint32_t value;
+                    std::memcpy(&value, p, sizeof(value));
+                    return value;
+                }
+
+                // Inline floor, a libm call inside the AVX2 kernels costs a state transition
+                inline int floor_int(float f)
+                {
+                    int i = (int)f;
+                    return i - (f < (float)i);
+                }
+
+                // First texel if the span can be copied straight from one image row, otherwise null
+                const Color* contiguous_row(const Span& span, int count)
+                {
+                    if (span.scale_mode != ScaleMode::NEAREST || span.du != 1 || span.dv != 0)
+                        return nullptr;
+
+                    int x = floor_int(span.u), y = floor_int(span.v);
+                    if (x < span.area.x0 || x + count - 1 > span.area.x1
+                        || y < span.area.y0 || y > span.area.y1)
+                        return nullptr;
+                    return span.image + y * span.pitch + x;
+                }
+            }
+
+            void blit_scalar(Color* dst, int count, const Span& span)
+            {
+                bool tinted = load_pixel(&span.tint) != load_pixel(&Colors::WHITE);
+
+                for (int i = 0; i < count; i++)
+                {
+                    Color texel = fetch(span, i);
+                    if (tinted)
+                        texel = modulate(texel, span.tint);
+                    blend_pixel(dst[i], texel, span.blend_mode);
+                }
+            }
+
+#if SE_SSE2
+            namespace
+            {
+                // x / 255 rounded, exact for x <= 255 * 255
+                inline __m128i div255_sse2(__m128i x)
+                {
+                    __m128i t = _mm_add_epi16(x, _mm_set1_epi16(128));
+                    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+                }
+
+                inline __m128i mul8_sse2(__m128i a, __m128i b)
+                {
+                    return div255_sse2(_mm_mullo_epi16(a, b));
+                }
+
+                // Copy the alpha of every pixel to its four 16-bit lanes
+                inline __m128i alpha_sse2(__m128i x)
+                {
+                    x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+                    return _mm_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+                }
+
+                inline __m128i select_sse2(__m128i mask, __m128i a, __m128i b)
+                {
+                    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+                }
+
+                // Blend two pixels unpacked to 16-bit lanes, the result is still unpacked
+                template<BlendMode MODE>
+                inline __m128i blend2_sse2(__m128i s, __m128i d)
+                {
+                    __m128i a = alpha_sse2(s);
+                    switch (MODE)
+                    {
+                        default:
+                        case BlendMode::NORMAL:
+                        {
+                            // A source alpha of 255 turns the alpha lane into a + d.a * (255 - a) / 255
+                            __m128i alpha_lanes = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+                            __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), a);
+                            return div255_sse2(_mm_add_epi16(
+                                _mm_mullo_epi16(_mm_or_si128(s, alpha_lanes), a),
+                                _mm_mullo_epi16(d, inv)));
+                        }
+
+                        case BlendMode::MULTIPLY:
+                            return mul8_sse2(s, d);
+
+                        // ADD and SUBTRACT blend saturated 8-bit values in blend4_sse2()
+                        case BlendMode::ADD:
+                        case BlendMode::SUBTRACT:
+                            return mul8_sse2(s, a);
+                    }
+                }
+
+                template<BlendMode MODE>
+                inline __m128i blend4_sse2(__m128i src, __m128i dst, __m128i tint, bool tinted)
+                {
+                    const __m128i zero = _mm_setzero_si128();
+                    const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+
+                    __m128i s_lo = _mm_unpacklo_epi8(src, zero);
+                    __m128i s_hi = _mm_unpackhi_epi8(src, zero);
+                    if (tinted)
+                    {
+                        s_lo = mul8_sse2(s_lo, tint);
+                        s_hi = mul8_sse2(s_hi, tint);
+                    }
+
+                    __m128i d_lo = _mm_unpacklo_epi8(dst, zero);
+                    __m128i d_hi = _mm_unpackhi_epi8(dst, zero);
+                    __m128i result = _mm_packus_epi16(blend2_sse2<MODE>(s_lo, d_lo),
+                        blend2_sse2<MODE>(s_hi, d_hi));
+
+                    switch (MODE)
+                    {
+                        default:
+                        case BlendMode::NORMAL:
+                            return result;
+
+                        case BlendMode::ADD:
+                            return select_sse2(alpha_mask, dst, _mm_adds_epu8(dst, result));
+
+                        case BlendMode::SUBTRACT:
+                            // The alpha is added, the colour is subtracted
+                            return select_sse2(alpha_mask, _mm_adds_epu8(dst, result),
+                                _mm_subs_epu8(dst, result));
+
+                        case BlendMode::MULTIPLY:
+                            return select_sse2(alpha_mask, dst, result);
+                    }
+                }
+
+                inline __m128i gather_nearest_sse2(const Span& span, int i)
+                {
+                    __m128 index = _mm_add_ps(_mm_set1_ps((float)i), _mm_setr_ps(0, 1, 2, 3));
+                    __m128 u = _mm_add_ps(_mm_set1_ps(span.u), _mm_mul_ps(_mm_set1_ps(span.du), index));
+                    __m128 v = _mm_add_ps(_mm_set1_ps(span.v), _mm_mul_ps(_mm_set1_ps(span.dv), index));
+
+                    u = _mm_min_ps(_mm_max_ps(u, _mm_set1_ps((float)span.area.x0)), _mm_set1_ps((float)span.area.x1));
+                    v = _mm_min_ps(_mm_max_ps(v, _mm_set1_ps((float)span.area.y0)), _mm_set1_ps((float)span.area.y1));
+
+                    alignas(16) int32_t x[4], y[4];
+                    _mm_store_si128((__m128i*)x, _mm_cvttps_epi32(u));
+                    _mm_store_si128((__m128i*)y, _mm_cvttps_epi32(v));
+
+                    const Color* image = span.image;
+                    int pitch = span.pitch;
+                    return _mm_setr_epi32(
+                        (int)load_pixel(image + y[0] * pitch + x[0]), (int)load_pixel(image + y[1] * pitch + x[1]),
+                        (int)load_pixel(image + y[2] * pitch + x[2]), (int)load_pixel(image + y[3] * pitch + x[3]));
+                }
+
+                template<BlendMode MODE>
+                void blit_sse2_mode(Color* dst, int count, const Span& span)
+                {
+                    bool tinted = load_pixel(&span.tint) != load_pixel(&Colors::WHITE);
+                    __m128i tint = _mm_unpacklo_epi8(_mm_set1_epi32((int)load_pixel(&span.tint)), _mm_setzero_si128());
+
+                    const Color* row = contiguous_row(span, count);
+                    bool linear = span.scale_mode == ScaleMode::LINEAR;
+
+                    int i = 0;
+                    for (; i + 4 <= count; i += 4)
+                    {
+                        __m128i src;
+                        if (row)
+                            src = _mm_loadu_si128((const __m128i*)(row + i));
+                        else if (!linear)
+                            src = gather_nearest_sse2(span, i);
+                        else
+                        {
+                            Color texels[4];
+                            for (int k = 0; k < 4; k++)
+                                texels[k] = fetch(span, i + k);
+                            src = _mm_loadu_si128((const __m128i*)texels);
+                        }
+
+                        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+                        _mm_storeu_si128((__m128i*)(dst + i), blend4_sse2<MODE>(src, d, tint, tinted));
+                    }
+
+                    for (; i < count; i++)
+                    {
+                        Color texel = fetch(span, i);
+                        if (tinted)
+                            texel = modulate(texel, span.tint);
+                        blend_pixel(dst[i], texel, MODE);
+                    }
+                }
+            }
+
+            static void blit_sse2(Color* dst, int count, const Span& span)
+            {
+                switch (span.blend_mode)
+                {
+                    default:
+                    case BlendMode::NORMAL: blit_sse2_mode<BlendMode::NORMAL>(dst, count, span); break;
+                    case BlendMode::ADD: blit_sse2_mode<BlendMode::ADD>(dst, count, span); break;
+                    case BlendMode::SUBTRACT: blit_sse2_mode<BlendMode::SUBTRACT>(dst, count, span); break;
+                    case BlendMode::MULTIPLY: blit_sse2_mode<BlendMode::MULTIPLY>(dst, count, span); break;
+                }
+            }
+#endif // SE_SSE2
+
+#if BLIT_AVX2
+            namespace
+            {
+                // Same as the SSE2 versions above on two 128-bit lanes at once
+
+                BLIT_TARGET_AVX2 inline __m256i div255_avx2(__m256i x)
+                {
+                    __m256i t = _mm256_add_epi16(x, _mm256_set1_epi16(128));
+                    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+                }
+
+                BLIT_TARGET_AVX2 inline __m256i mul8_avx2(__m256i a, __m256i b)
+                {
+                    return div255_avx2(_mm256_mullo_epi16(a, b));
+                }
+
+                BLIT_TARGET_AVX2 inline __m256i alpha_avx2(__m256i x)
+                {
+                    x = _mm256_shufflelo_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+                    return _mm256_shufflehi_epi16(x, _MM_SHUFFLE(3, 3, 3, 3));
+                }
+
+                BLIT_TARGET_AVX2 inline __m256i select_avx2(__m256i mask, __m256i a, __m256i b)
+                {
+                    return _mm256_blendv_epi8(b, a, mask);
+                }
+
+                template<BlendMode MODE>
+                BLIT_TARGET_AVX2 inline __m256i blend4_avx2(__m256i s, __m256i d)
+                {
+                    __m256i a = alpha_avx2(s);
+                    switch (MODE)
+                    {
+                        default:
+                        case BlendMode::NORMAL:
+                        {
+                            __m256i alpha_lanes = _mm256_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255,
+                                0, 0, 0, 255, 0, 0, 0, 255);
+                            __m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(255), a);
+                            return div255_avx2(_mm256_add_epi16(
+                                _mm256_mullo_epi16(_mm256_or_si256(s, alpha_lanes), a),
+                                _mm256_mullo_epi16(d, inv)));
+                        }
+
+                        case BlendMode::MULTIPLY:
+                            return mul8_avx2(s, d);
+
+                        case BlendMode::ADD:
+                        case BlendMode::SUBTRACT:
+                            return mul8_avx2(s, a);
+                    }
+                }
+
+                template<BlendMode MODE>
+                BLIT_TARGET_AVX2 inline __m256i blend8_avx2(__m256i src, __m256i dst, __m256i tint, bool tinted)
+                {
+                    const __m256i zero = _mm256_setzero_si256();
+                    const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
+
+                    // Unpacking and packing stay inside the 128-bit lanes,
+                    // so the pixel order is preserved
+                    __m256i s_lo = _mm256_unpacklo_epi8(src, zero);
+                    __m256i s_hi = _mm256_unpackhi_epi8(src, zero);
+                    if (tinted)
+                    {
+                        s_lo = mul8_avx2(s_lo, tint);
+                        s_hi = mul8_avx2(s_hi, tint);
+                    }
+
+                    __m256i d_lo = _mm256_unpacklo_epi8(dst, zero);
+                    __m256i d_hi = _mm256_unpackhi_epi8(dst, zero);
+                    __m256i result = _mm256_packus_epi16(blend4_avx2<MODE>(s_lo, d_lo),
+                        blend4_avx2<MODE>(s_hi, d_hi));
+
+                    switch (MODE)
+                    {
+                        default:
+                        case BlendMode::NORMAL:
+                            return result;
+
+                        case BlendMode::ADD:
+                            return select_avx2(alpha_mask, dst, _mm256_adds_epu8(dst, result));
+
+                        case BlendMode::SUBTRACT:
+                            return select_avx2(alpha_mask, _mm256_adds_epu8(dst, result),
+                                _mm256_subs_epu8(dst, result));
+
+                        case BlendMode::MULTIPLY:
+                            return select_avx2(alpha_mask, dst, result);
+                    }
+                }
+
+                BLIT_TARGET_AVX2 inline __m256i gather_nearest_avx2(const Span& span, int i)
+                {
+                    __m256 index = _mm256_add_ps(_mm256_set1_ps((float)i), _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7));
+                    __m256 u = _mm256_add_ps(_mm256_set1_ps(span.u), _mm256_mul_ps(_mm256_set1_ps(span.du), index));
+                    __m256 v = _mm256_add_ps(_mm256_set1_ps(span.v), _mm256_mul_ps(_mm256_set1_ps(span.dv), index));
+
+                    u = _mm256_min_ps(_mm256_max_ps(u, _mm256_set1_ps((float)span.area.x0)), _mm256_set1_ps((float)span.area.x1));
+                    v = _mm256_min_ps(_mm256_max_ps(v, _mm256_set1_ps((float)span.area.y0)), _mm256_set1_ps((float)span.area.y1));
+
+                    __m256i offset = _mm256_add_epi32(
+                        _mm256_mullo_epi32(_mm256_cvttps_epi32(v), _mm256_set1_epi32(span.pitch)),
+                        _mm256_cvttps_epi32(u));
+                    return _mm256_i32gather_epi32((const int*)span.image, offset, 4);
+                }
+
+                template<BlendMode MODE>
+                BLIT_TARGET_AVX2 void blit_avx2_mode(Color* dst, int count, const Span& span)
+                {
+                    const Color* row = contiguous_row(span, count);
+                    bool tinted = load_pixel(&span.tint) != load_pixel(&Colors::WHITE);
+                    __m256i tint = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)load_pixel(&span.tint)),
+                        _mm256_setzero_si256());
+                    bool linear = span.scale_mode == ScaleMode::LINEAR;
+
+                    int i = 0;
+                    for (; i + 8 <= count; i += 8)
+                    {
+                        __m256i src;
+                        if (row)
+                            src = _mm256_loadu_si256((const __m256i*)(row + i));
+                        else if (!linear)
+                            src = gather_nearest_avx2(span, i);
+                        else
+                        {
+                            Color texels[8];
+                            for (int k = 0; k < 8; k++)
+                                texels[k] = fetch(span, i + k);
+                            src = _mm256_loadu_si256((const __m256i*)texels);
+                        }
+
+                        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+                        _mm256_storeu_si256((__m256i*)(dst + i), blend8_avx2<MODE>(src, d, tint, tinted));
+                    }
+
+                    for (; i < count; i++)
+                    {
+                        Color texel = fetch(span, i);
+                        if (tinted)
+                            texel = modulate(texel, span.tint);
+                        blend_pixel(dst[i], texel, MODE);
+                    }
+                }
+
+                bool cpu_has_avx2()
+                {
+#if defined(_MSC_VER) && !defined(__clang__)
+                    int info[4];
+                    __cpuid(info, 1);
+                    bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28))
+                        && (_xgetbv(0) & 6) == 6;
+                    if (!os_saves_ymm)
+                        return false;
+
+                    __cpuidex(info, 7, 0);
+                    return info[1] & (1 << 5);
+#else
+                    return __builtin_cpu_supports("avx2");
+#endif
+                }
+            }
+
+            static BLIT_TARGET_AVX2 void blit_avx2(Color* dst, int count, const Span& span)
+            {
+                switch (span.blend_mode)
+                {
+                    default:
+                    case BlendMode::NORMAL: blit_avx2_mode<BlendMode::NORMAL>(dst, count, span); break;
+                    case BlendMode::ADD: blit_avx2_mode<BlendMode::ADD>(dst, count, span); break;
+                    case BlendMode::SUBTRACT: blit_avx2_mode<BlendMode::SUBTRACT>(dst, count, span); break;
+                    case BlendMode::MULTIPLY: blit_avx2_mode<BlendMode::MULTIPLY>(dst, count, span); break;
+                }
+            }
+#endif // BLIT_AVX2
+
+            namespace
+            {
+                struct KernelInfo
+                {
+                    Kernel kernel;
+                    const char* name;
+                };
+
+                // A NEON kernel would be one more case here
+                KernelInfo detect_kernel()
+                {
+#if BLIT_AVX2
+                    if (cpu_has_avx2())
+                        return { blit_avx2, "AVX2" };
+#endif
+#if SE_SSE2
+                    return { blit_sse2, "SSE2" };
+#else
+                    return { blit_scalar, "scalar" };
+#endif
+                }
+
+                const KernelInfo& get_best_kernel()
+                {
+                    static KernelInfo info = detect_kernel();
+                    return info;
+                }
+            }
+
+            Kernel get_kernel()
+            {
+                return force_scalar ? blit_scalar : get_best_kernel().kernel;
+            }
+
+            const char* get_kernel_name()
+            {
+                return force_scalar ? "scalar" : get_best_kernel().name;
+            }
+
+            void use_scalar_kernel(bool flag)
+            {
+                force_scalar = flag;
+            }
+
+            Kernel find_kernel(const char* name)
+            {
+                if (std::strcmp(name, "scalar") == 0)
+                    return blit_scalar;
+#if SE_SSE2
+                if (std::strcmp(name, "SSE2") == 0)
+                    return blit_sse2;
+#endif
+#if BLIT_AVX2
+                if (std::strcmp(name, "AVX2") == 0 && cpu_has_avx2())
+                    return blit_avx2;
+#endif
+                return nullptr;
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef __SOFTWAREBLIT_H__
+#define __SOFTWAREBLIT_H__
+
+#include "Renderer.hpp"
+#include "Color.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Sputnik
+{
+    namespace Renderer
+    {
+        /*
+            Inner loops of the software renderer.
+
+            A span is a run of destination pixels in one row. The texel
+            coordinates change linearly along it, which covers axis-aligned
+            copies, scaled copies and rotated (affine) blits alike.
+            Every kernel gives the same result as the scalar reference.
+        */
+        namespace Blit
+        {
+            // Texel area a span samples from, x1 and y1 are inclusive
+            struct Area
+            {
+                int x0, y0, x1, y1;
+            };
+
+            struct Span
+            {
+                const Color* image;
+                // Pixels per image row
+                int pitch;
+                Area area;
+                // Texel coordinates of the first pixel centre and their change per pixel
+                float u, v;
+                float du, dv;
+                Color tint;
+                BlendMode blend_mode;
+                ScaleMode scale_mode;
+            };
+
+            using Kernel = void (*)(Color* dst, int count, const Span& span);
+
+            // Scalar reference implementation
+            void blit_scalar(Color* dst, int count, const Span& span);
+
+            // Fastest kernel the CPU supports, detected on the first call
+            Kernel get_kernel();
+            const char* get_kernel_name();
+            // Force the scalar kernel, e.g. to compare the results
+            void use_scalar_kernel(bool flag);
+            // Kernel by name ("scalar", "SSE2", "AVX2"), null if it isn't built or the CPU lacks it
+            Kernel find_kernel(const char* name);
+
+            // a * b / 255, rounded
+            inline uint8_t mul8(int a, int b)
+            {
+                return (uint8_t)((a * b + 127) / 255);
+            }
+
+            inline Color modulate(Color c, Color tint)
+            {
+                return { mul8(c.r, tint.r), mul8(c.g, tint.g), mul8(c.b, tint.b), mul8(c.a, tint.a) };
+            }
+
+            // Same equations as the blend modes of SDL2_Renderer
+            inline void blend_pixel(Color& d, Color s, BlendMode mode)
+            {
+                int a = s.a;
+                switch (mode)
+                {
+                    default:
+                    case BlendMode::NORMAL:
+                        d.r = (uint8_t)((s.r * a + d.r * (255 - a) + 127) / 255);
+                        d.g = (uint8_t)((s.g * a + d.g * (255 - a) + 127) / 255);
+                        d.b = (uint8_t)((s.b * a + d.b * (255 - a) + 127) / 255);
+                        d.a = (uint8_t)(a + mul8(d.a, 255 - a));
+                        break;
+
+                    case BlendMode::ADD:
+                        d.r = (uint8_t)std::min(255, d.r + mul8(s.r, a));
+                        d.g = (uint8_t)std::min(255, d.g + mul8(s.g, a));
+                        d.b = (uint8_t)std::min(255, d.b + mul8(s.b, a));
+                        break;
+
+                    case BlendMode::SUBTRACT:
+                        d.r = (uint8_t)std::max(0, d.r - mul8(s.r, a));
+                        d.g = (uint8_t)std::max(0, d.g - mul8(s.g, a));
+                        d.b = (uint8_t)std::max(0, d.b - mul8(s.b, a));
+                        d.a = (uint8_t)std::min(255, d.a + mul8(a, a));
+                        break;
+
+                    case BlendMode::MULTIPLY:
+                        d.r = mul8(s.r, d.r);
+                        d.g = mul8(s.g, d.g);
+                        d.b = mul8(s.b, d.b);
+                        break;
+                }
+            }
+
+            inline Color sample_nearest(const Span& span, float u, float v)
+            {
+                // Clamping before the conversion makes truncation act as floor
+                int x = (int)std::min(std::max(u, (float)span.area.x0), (float)span.area.x1);
+                int y = (int)std::min(std::max(v, (float)span.area.y0), (float)span.area.y1);
+                return span.image[y * span.pitch + x];
+            }
+
+            inline Color sample_linear(const Span& span, float u, float v)
+            {
+                const Area& area = span.area;
+                float fx = u - 0.5f, fy = v - 0.5f;
+                float bx = std::floor(fx), by = std::floor(fy);
+                int tx = (int)((fx - bx) * 256), ty = (int)((fy - by) * 256);
+
+                int x0 = std::min(std::max((int)bx, area.x0), area.x1);
+                int x1 = std::min(std::max((int)bx + 1, area.x0), area.x1);
+                int y0 = std::min(std::max((int)by, area.y0), area.y1);
+                int y1 = std::min(std::max((int)by + 1, area.y0), area.y1);
+
+                const Color* row0 = span.image + y0 * span.pitch;
+                const Color* row1 = span.image + y1 * span.pitch;
+                Color c00 = row0[x0], c10 = row0[x1];
+                Color c01 = row1[x0], c11 = row1[x1];
+
+                auto lerp = [=](int p00, int p10, int p01, int p11) {
+                    int top = p00 * (256 - tx) + p10 * tx;
+                    int bottom = p01 * (256 - tx) + p11 * tx;
+                    return (uint8_t)((top * (256 - ty) + bottom * ty + 32768) >> 16);
+                };
+
+                return { lerp(c00.r, c10.r, c01.r, c11.r), lerp(c00.g, c10.g, c01.g, c11.g),
+                    lerp(c00.b, c10.b, c01.b, c11.b), lerp(c00.a, c10.a, c01.a, c11.a) };
+            }
+
+            // Texel for the i-th pixel of the span
+            inline Color fetch(const Span& span, int i)
+            {
+                float u = span.u + span.du * (float)i;
+                float v = span.v + span.dv * (float)i;
+                return span.scale_mode == ScaleMode::LINEAR
+                    ? sample_linear(span, u, v) : sample_nearest(span, u, v);
+            }
+        }
+    }
+}
+
+#endif // __SOFTWAREBLIT_H__
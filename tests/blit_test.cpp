@@ -0,0 +1,143 @@
+// Compares the SIMD blit kernels against the scalar reference on random spans
+
+#include "renderers/SoftwareBlit.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Sputnik;
+using namespace Sputnik::Renderer;
+
+namespace
+{
+    const int IMAGE_W = 37;
+    const int IMAGE_H = 23;
+    const int ITERATIONS = 200000;
+
+    enum class SpanKind { STRAIGHT, SCALED, AFFINE, COUNT };
+
+    const char* kind_names[] = { "straight", "scaled", "affine" };
+    const char* blend_names[] = { "NORMAL", "ADD", "SUBTRACT", "MULTIPLY" };
+    const char* scale_names[] = { "NEAREST", "LINEAR" };
+
+    Color random_color(std::mt19937& rng)
+    {
+        uint32_t value = rng();
+        Color color;
+        std::memcpy(&color, &value, sizeof(color));
+        return color;
+    }
+
+    // Random float in [min, max) with a few fractional bits, so the spans hit texel edges
+    float random_float(std::mt19937& rng, float min, float max)
+    {
+        return min + (float)(rng() % 4096) / 4096.0f * (max - min);
+    }
+
+    Blit::Span random_span(std::mt19937& rng, const std::vector<Color>& image, SpanKind kind)
+    {
+        Blit::Span span;
+        span.image = image.data();
+        span.pitch = IMAGE_W;
+
+        int x0 = rng() % IMAGE_W, y0 = rng() % IMAGE_H;
+        span.area = { x0, y0, x0 + (int)(rng() % (IMAGE_W - x0)), y0 + (int)(rng() % (IMAGE_H - y0)) };
+
+        // Start a bit outside the area too, the kernels have to clamp like the reference
+        span.u = random_float(rng, -2, IMAGE_W + 2);
+        span.v = random_float(rng, -2, IMAGE_H + 2);
+
+        switch (kind)
+        {
+            default:
+            case SpanKind::STRAIGHT:
+                // Texel centres along one row, the contiguous copy path
+                span.u = std::floor(span.u) + 0.5f;
+                span.v = std::floor(span.v) + 0.5f;
+                span.du = 1;
+                span.dv = 0;
+                break;
+
+            case SpanKind::SCALED:
+                span.du = random_float(rng, -2.5f, 2.5f);
+                span.dv = 0;
+                break;
+
+            case SpanKind::AFFINE:
+                span.du = random_float(rng, -1.5f, 1.5f);
+                span.dv = random_float(rng, -1.5f, 1.5f);
+                break;
+        }
+
+        span.tint = rng() % 2 ? Colors::WHITE : random_color(rng);
+        span.blend_mode = (BlendMode)(rng() % 4);
+        span.scale_mode = (ScaleMode)(rng() % 2);
+        return span;
+    }
+
+    // Returns the number of spans where the kernel differs from blit_scalar
+    int compare(const char* name, Blit::Kernel kernel)
+    {
+        std::mt19937 rng(1);
+        std::vector<Color> image(IMAGE_W * IMAGE_H);
+        for (auto& color : image)
+            color = random_color(rng);
+
+        int mismatches = 0;
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            SpanKind kind = (SpanKind)(i % (int)SpanKind::COUNT);
+            Blit::Span span = random_span(rng, image, kind);
+
+            // Lengths around the vector widths exercise the tail loops
+            int count = rng() % 40;
+            std::vector<Color> expected(count);
+            for (auto& color : expected)
+                color = random_color(rng);
+            std::vector<Color> result = expected;
+
+            Blit::blit_scalar(expected.data(), count, span);
+            kernel(result.data(), count, span);
+
+            if (count == 0 || std::memcmp(expected.data(), result.data(), count * sizeof(Color)) == 0)
+                continue;
+
+            if (mismatches++ < 5)
+            {
+                int p = 0;
+                while (std::memcmp(&expected[p], &result[p], sizeof(Color)) == 0)
+                    p++;
+
+                std::printf("%s: %s span, %s, %s, %s, pixel %d: %d %d %d %d instead of %d %d %d %d\n",
+                    name, kind_names[(int)kind], blend_names[(int)span.blend_mode],
+                    scale_names[(int)span.scale_mode],
+                    std::memcmp(&span.tint, &Colors::WHITE, sizeof(Color)) ? "tinted" : "untinted", p,
+                    result[p].r, result[p].g, result[p].b, result[p].a,
+                    expected[p].r, expected[p].g, expected[p].b, expected[p].a);
+            }
+        }
+
+        std::printf("%s: %d of %d spans differ\n", name, mismatches, ITERATIONS);
+        return mismatches;
+    }
+}
+
+int main()
+{
+    int failures = 0;
+    for (const char* name : { "SSE2", "AVX2" })
+    {
+        Blit::Kernel kernel = Blit::find_kernel(name);
+        if (!kernel)
+        {
+            std::printf("%s: not available, skipped\n", name);
+            continue;
+        }
+
+        failures += compare(name, kernel);
+    }
+
+    return failures ? 1 : 0;
+}
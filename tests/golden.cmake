@@ -0,0 +1,17 @@
+# Runs the game headless until frame 60, saves it and compares it with REFERENCE.
+# A changed reference is made the same way: run the game with
+# SPUTNIK_GOLDEN_IMAGE=tests/golden/level_60.pam from the source directory.
+
+set(ENV{SPUTNIK_GOLDEN_IMAGE} ${OUTPUT})
+set(ENV{SPUTNIK_GOLDEN_FRAME} 60)
+file(REMOVE ${OUTPUT})
+
+execute_process(COMMAND ${GAME} RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "The game exited with ${result}")
+endif()
+
+execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files ${OUTPUT} ${REFERENCE} RESULT_VARIABLE different)
+if (different)
+    message(FATAL_ERROR "${OUTPUT} differs from ${REFERENCE}")
+endif()